@@ -0,0 +1,90 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef HeadlessSim_h
+#define HeadlessSim_h
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace xpilot
+{
+	/**
+	 * Controls the in-process stand-in for X-Plane and XPMP2 that the headless tools link
+	 * against instead of the SDK (XPLMStub.cpp, XPMP2Stub.cpp). Nothing is thread-safe, just
+	 * like the SDK: the thread that calls runFrame() plays the sim thread.
+	 *
+	 * The stand-in has a dataref registry (any name X-Plane doesn't know is plain storage,
+	 * plugins can register accessors), terrain probes over a synthetic heightfield, flight
+	 * loops that run once per runFrame(), and XPMP2 aircraft that are matched against a
+	 * model list and updated from XPMP2's own flight loop like the real library does.
+	 */
+	class HeadlessSim
+	{
+	public:
+		/**
+		 * Terrain elevation in meters at a position. NaN makes the terrain probe miss there.
+		 */
+		typedef std::function<double(double latitude, double longitude)> Heightfield;
+
+		/**
+		 * Replaces the terrain; the default is gently rolling terrain around 100 m.
+		 */
+		static void setHeightfield(const Heightfield& heightfield);
+
+		/**
+		 * Puts the camera, which XPMP2 measures the aircraft distances from. Also moves the
+		 * origin of the local coordinates there, like X-Plane does when the scenery shifts.
+		 */
+		static void setCamera(double latitude, double longitude, double altitudeMeters);
+
+		/**
+		 * Advances the sim clock by the elapsed seconds and runs one frame: every flight loop
+		 * that is due, in the order they were registered.
+		 */
+		static void runFrame(float elapsed);
+
+		static float elapsedTime();
+		static int frameCount();
+		static uint64_t probeCount();
+
+		/**
+		 * Sets a dataref no plugin provides, the way X-Plane would.
+		 */
+		static void setDatai(const char* name, int value);
+		static void setDataf(const char* name, float value);
+		static void setDatad(const char* name, double value);
+
+		/**
+		 * Adds a CSL model to the XPMP2 stand-in. Without any models, every aircraft type
+		 * gets a model of its own with the cslId "Headless/<type>".
+		 */
+		static void addModel(const std::string& cslId, const std::string& icaoType, const std::string& airline = "", const std::string& livery = "");
+
+		static size_t aircraftCount();
+
+		/**
+		 * Number of times XPMP2 had to search its models for an aircraft (ChangeModel, or
+		 * creating one without a cslId).
+		 */
+		static uint64_t modelMatchCount();
+	};
+}
+
+#endif // !HeadlessSim_h
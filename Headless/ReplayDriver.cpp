@@ -0,0 +1,222 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+// Replays a session capture (see SessionCapture.h) through the traffic pipeline of the
+// plugin, without X-Plane:
+//
+//   xPilotReplay <capture file> [speed]
+//
+// speed scales the original timing of the capture (default 1), 0 replays it as fast as
+// possible. Messages are decoded on the replay thread and run on the "sim thread" the way
+// the plugin does it; every frame interpolates the aircraft. Prints the frame times, the
+// latency statistics and what XPMP2 and the terrain probes were asked to do.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "HeadlessSim.h"
+#include "AircraftManager.h"
+#include "AsyncLog.h"
+#include "LatencyTracker.h"
+#include "SessionCapture.h"
+#include "TrafficDecoder.h"
+#include "XPLMProcessing.h"
+#include "XPMPMultiplayer.h"
+#include "json.hpp"
+
+using namespace xpilot;
+using json = nlohmann::json;
+
+namespace
+{
+	constexpr float FrameTime = 1.0f / 60.0f;
+
+	// how long to keep drawing after the last message, so the buffered states play out
+	constexpr auto DrainTime = std::chrono::microseconds(LatencyTracker::FixedBufferDelay + 1000000);
+
+	std::mutex queueMutex;
+	std::deque<std::function<void()>> queuedCallbacks;
+
+	AircraftManager* aircraftManager = nullptr;
+	std::vector<long long> frameMicros;
+	size_t peakAircraft = 0;
+
+	void QueueCallback(const std::function<void()>& cb)
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		queuedCallbacks.push_back(cb);
+	}
+
+	float OnFlightLoop(float, float, int, void*)
+	{
+		const auto begin = std::chrono::steady_clock::now();
+
+		std::deque<std::function<void()>> callbacks;
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			callbacks.swap(queuedCallbacks);
+		}
+		for (auto& cb : callbacks)
+		{
+			cb();
+		}
+		aircraftManager->interpolateAirplanes();
+
+		frameMicros.push_back(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count());
+		peakAircraft = (std::max)(peakAircraft, HeadlessSim::aircraftCount());
+
+		AsyncLog::Instance().flush(std::chrono::microseconds(500));
+		return -1.0f;
+	}
+
+	void PrintLatency()
+	{
+		const LatencyTracker& tracker = LatencyTracker::Instance();
+		for (size_t i = 0; i < LatencyHopCount; i++)
+		{
+			const LatencyHop hop = static_cast<LatencyHop>(i);
+			const LatencyStats& stats = tracker.hopStats(hop);
+			printf("  %-14s p50 %8.2f ms  p99 %8.2f ms  (%llu samples)\n", LatencyHopName(hop),
+				stats.p50 / 1000.0, stats.p99 / 1000.0, (unsigned long long)stats.count);
+		}
+		printf("  underruns  %.2f%%  buffer delay %.0f ms\n", tracker.underrunRate() * 100.0f, tracker.bufferDelay() / 1000.0);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		fprintf(stderr, "usage: %s <capture file> [speed]\n", argv[0]);
+		return 2;
+	}
+	const std::string path = argv[1];
+	const double speed = argc > 2 ? atof(argv[2]) : 1.0;
+
+	XPMPMultiplayerInit("xPilot", "", nullptr, "A320");
+
+	AircraftManager manager;
+	aircraftManager = &manager;
+	TrafficDecoder decoder(&manager, QueueCallback);
+	bool cameraPlaced = false;
+
+	SessionPlayer player([&](const std::string& data)
+	{
+		const long long receivedAt = SteadyMicros();
+		if (!json::accept(data.c_str()))
+			return;
+
+		json j = json::parse(data.c_str());
+		if (j.find("Type") == j.end())
+			return;
+
+		const std::string type(j["Type"]);
+		if (!TrafficDecoder::isTraffic(type))
+			return;
+
+		// the camera goes where the first aircraft shows up
+		if (!cameraPlaced && type == "PositionUpdate")
+		{
+			cameraPlaced = true;
+			const double latitude = j["Data"]["Latitude"];
+			const double longitude = j["Data"]["Longitude"];
+			QueueCallback([=]()
+			{
+				HeadlessSim::setCamera(latitude, longitude, 500.0);
+			});
+		}
+		decoder.decode(type, j, receivedAt);
+	});
+
+	XPLMRegisterFlightLoopCallback(OnFlightLoop, -1.0f, nullptr);
+
+	if (!player.start(path, speed))
+	{
+		AsyncLog::Instance().flushAll();
+		return 1;
+	}
+
+	const auto begin = std::chrono::steady_clock::now();
+	auto nextFrame = begin;
+	auto lastMessage = begin;
+	auto nextReport = begin + std::chrono::seconds(10);
+	while (true)
+	{
+		const auto now = std::chrono::steady_clock::now();
+		if (player.isPlaying())
+		{
+			lastMessage = now;
+		}
+		else if (now - lastMessage > DrainTime)
+		{
+			break;
+		}
+
+		HeadlessSim::runFrame(FrameTime);
+
+		if (now >= nextReport)
+		{
+			nextReport += std::chrono::seconds(10);
+			LatencyTracker::Instance().publish();
+			printf("%.0f s: %zu aircraft, latency over the last 10 s:\n",
+				std::chrono::duration<double>(now - begin).count(), HeadlessSim::aircraftCount());
+			PrintLatency();
+		}
+
+		// frames at 60 Hz of wall time, the aircraft are interpolated in wall time too
+		nextFrame += std::chrono::microseconds(static_cast<long long>(FrameTime * 1000000));
+		std::this_thread::sleep_until(nextFrame);
+	}
+
+	const double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+	player.stop();
+	manager.removeAllPlanes();
+	XPMPMultiplayerCleanup();
+	AsyncLog::Instance().flushAll();
+
+	std::vector<long long> sorted = frameMicros;
+	std::sort(sorted.begin(), sorted.end());
+	const auto percentile = [&](double p)
+	{
+		return sorted.empty() ? 0.0 : sorted[static_cast<size_t>(p * (sorted.size() - 1))] / 1000.0;
+	};
+	double total = 0.0;
+	for (long long micros : sorted)
+	{
+		total += micros;
+	}
+
+	printf("\nReplayed %s in %.1f s, %d frames\n", path.c_str(), wallSeconds, HeadlessSim::frameCount());
+	printf("frame (drain + interpolation): mean %.3f ms  p50 %.3f ms  p99 %.3f ms  max %.3f ms\n",
+		sorted.empty() ? 0.0 : total / sorted.size() / 1000.0, percentile(0.50), percentile(0.99), percentile(1.0));
+	printf("aircraft: peak %zu  model matches %llu  terrain probes %llu (%.1f per frame)\n", peakAircraft,
+		(unsigned long long)HeadlessSim::modelMatchCount(), (unsigned long long)HeadlessSim::probeCount(),
+		HeadlessSim::frameCount() > 0 ? double(HeadlessSim::probeCount()) / HeadlessSim::frameCount() : 0.0);
+	LatencyTracker::Instance().publish();
+	printf("latency since the last report:\n");
+	PrintLatency();
+	return 0;
+}
@@ -0,0 +1,193 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+// Runs the traffic benchmark (see TrafficBenchmark.h) without X-Plane:
+//
+//   xPilotTrafficBenchmark [result file] [latitude longitude]
+//
+// The synthetic traffic goes through the TrafficDecoder and AircraftManager on the stub
+// layer, one frame every 1/60 s of wall time, with the flight loop profiled the way the
+// plugin does it. Heap allocations are counted by replacing operator new, so the results
+// also have the allocations per frame. Takes a few minutes: every step warms up for 8 s
+// and measures for 20 s.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+
+#include "HeadlessSim.h"
+#include "AircraftManager.h"
+#include "AsyncLog.h"
+#include "LatencyTracker.h"
+#include "Profiler.h"
+#include "TrafficBenchmark.h"
+#include "TrafficDecoder.h"
+#include "XPLMProcessing.h"
+#include "XPMPMultiplayer.h"
+#include "json.hpp"
+
+using namespace xpilot;
+using json = nlohmann::json;
+
+namespace
+{
+	std::atomic<uint64_t> allocations{ 0 };
+}
+
+void* operator new(std::size_t size)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* p = std::malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	return std::malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept
+{
+	return operator new(size, tag);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+namespace
+{
+	constexpr float FrameTime = 1.0f / 60.0f;
+
+	std::mutex queueMutex;
+	std::deque<std::function<void()>> queuedCallbacks;
+
+	AircraftManager* aircraftManager = nullptr;
+	TrafficBenchmark* benchmark = nullptr;
+
+	void QueueCallback(const std::function<void()>& cb)
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		queuedCallbacks.push_back(cb);
+	}
+
+	long long MicrosSince(std::chrono::steady_clock::time_point begin)
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count();
+	}
+
+	// the parts of XPilot::onFlightLoop that the benchmark measures
+	float OnFlightLoop(float, float, int, void*)
+	{
+		Profiler& profiler = Profiler::Instance();
+		profiler.endFrame();
+		ProfilerFrame frame;
+		if (benchmark->isRunning() && profiler.lastFrame(frame))
+		{
+			benchmark->onFrame(frame);
+		}
+
+		const auto drainStart = std::chrono::steady_clock::now();
+		std::deque<std::function<void()>> callbacks;
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			callbacks.swap(queuedCallbacks);
+		}
+		for (auto& cb : callbacks)
+		{
+			cb();
+		}
+		profiler.add(ProfilerStage::QueuedCallbacks, MicrosSince(drainStart));
+
+		const auto interpolationStart = std::chrono::steady_clock::now();
+		aircraftManager->interpolateAirplanes();
+		profiler.add(ProfilerStage::Interpolation, MicrosSince(interpolationStart));
+
+		LatencyTracker::Instance().update();
+		AsyncLog::Instance().flush(std::chrono::microseconds(500));
+		return -1.0f;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const std::string resultPath = argc > 1 ? argv[1] : "TrafficBenchmark.json";
+	const double latitude = argc > 3 ? atof(argv[2]) : 47.4647;
+	const double longitude = argc > 3 ? atof(argv[3]) : 8.5492;
+
+	HeadlessSim::setCamera(latitude, longitude, 500.0);
+	XPMPMultiplayerInit("xPilot", "", nullptr, "A320");
+
+	AircraftManager manager;
+	aircraftManager = &manager;
+	TrafficDecoder decoder(&manager, QueueCallback);
+
+	// the benchmark runs on the sim thread, so the messages are decoded there too, like
+	// XPilot::processMessage does for it
+	TrafficBenchmark trafficBenchmark([&](const std::string& data)
+	{
+		const long long receivedAt = SteadyMicros();
+		json j = json::parse(data);
+		const std::string type(j["Type"]);
+		if (TrafficDecoder::isTraffic(type))
+		{
+			decoder.decode(type, j, receivedAt);
+		}
+	});
+	trafficBenchmark.setAllocationCounter([]() { return allocations.load(std::memory_order_relaxed); });
+	benchmark = &trafficBenchmark;
+
+	Profiler::Instance().setEnabled(true);
+	XPLMRegisterFlightLoopCallback(OnFlightLoop, -1.0f, nullptr);
+
+	if (!trafficBenchmark.start(latitude, longitude, resultPath))
+		return 1;
+
+	auto nextFrame = std::chrono::steady_clock::now();
+	while (trafficBenchmark.isRunning())
+	{
+		HeadlessSim::runFrame(FrameTime);
+
+		// frames at 60 Hz of wall time, the aircraft are interpolated in wall time too
+		nextFrame += std::chrono::microseconds(static_cast<long long>(FrameTime * 1000000));
+		std::this_thread::sleep_until(nextFrame);
+	}
+
+	// the last RemovePlane messages are still queued
+	HeadlessSim::runFrame(FrameTime);
+	XPMPMultiplayerCleanup();
+	AsyncLog::Instance().flushAll();
+	return 0;
+}
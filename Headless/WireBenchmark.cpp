@@ -0,0 +1,263 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+// Measures the socket compression (see Compression.h) through a local ROUTER/DEALER pair:
+// the plugin's ZmqReactor on one end, a DEALER standing in for the pilot client on the other.
+//
+//   xPilotWireBenchmark [iterations] [port]
+//
+// For representative payloads, in both directions, with and without LZ4, prints the bytes
+// on the wire and the end-to-end latency of one message in flight: from the sender handing
+// over the message (before compression) to the receiver having decompressed and parsed it.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "AsyncLog.h"
+#include "Compression.h"
+#include "ZmqReactor.h"
+#include "json.hpp"
+
+using namespace xpilot;
+using json = nlohmann::json;
+
+namespace
+{
+	struct Payload
+	{
+		const char* name;
+		std::string message;
+	};
+
+	long long Now()
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	json PositionUpdate(int i)
+	{
+		json data;
+		data["Callsign"] = "DLH" + std::to_string(100 + i);
+		data["Latitude"] = 50.0333 + i * 0.0131;
+		data["Longitude"] = 8.5706 - i * 0.0217;
+		data["Altitude"] = 3500.0 + i * 250.0;
+		data["Heading"] = 247.5 + i;
+		data["Pitch"] = 2.5;
+		data["Bank"] = -1.25 * (i % 5);
+		data["GroundSpeed"] = 210.0 + i;
+		data["TransponderCode"] = 1000 + i;
+		data["TransponderModeC"] = true;
+		data["Origin"] = "EDDF";
+		data["Destination"] = "EGLL";
+		data["Timestamp"] = 1700000000000LL + i * 5000;
+		return data;
+	}
+
+	std::vector<Payload> Payloads()
+	{
+		std::vector<Payload> payloads;
+
+		json position;
+		position["Type"] = "PositionUpdate";
+		position["Timestamp"] = "2020-08-01T12:00:00Z";
+		position["Data"] = PositionUpdate(0);
+		payloads.push_back({ "PositionUpdate", position.dump() });
+
+		// what the batched position frames would look like: one update per aircraft in range
+		json batch;
+		batch["Type"] = "PositionBatch";
+		batch["Timestamp"] = "2020-08-01T12:00:00Z";
+		for (int i = 0; i < 25; i++)
+		{
+			batch["Data"].push_back(PositionUpdate(i));
+		}
+		payloads.push_back({ "PositionBatch x25", batch.dump() });
+
+		json radio;
+		radio["Type"] = "RadioMessage";
+		radio["Timestamp"] = "2020-08-01T12:00:00Z";
+		std::string atis = "EDDF_ATIS: FRANKFURT INFORMATION Q MET REPORT TIME 1150 EXPECT ILS Z APPROACH RUNWAY 25L AND 25C "
+			"DEPARTURES RUNWAY 25C AND 18 TRANSITION LEVEL 70 WIND 240 DEGREES 12 KNOTS VISIBILITY 10 KILOMETERS OR MORE "
+			"CLOUDS FEW 3500 FEET BROKEN 5000 FEET TEMPERATURE 18 DEW POINT 11 QNH 1016 TREND NOSIG ";
+		std::string text;
+		while (text.size() < 2000)
+		{
+			text += atis;
+		}
+		radio["Data"]["Message"] = text;
+		radio["Data"]["R"] = 255;
+		radio["Data"]["G"] = 255;
+		radio["Data"]["B"] = 255;
+		radio["Data"]["Direct"] = false;
+		payloads.push_back({ "RadioMessage 2 KB", radio.dump() });
+
+		static const char* const Facilities[] = { "DEL", "GND", "TWR", "APP", "DEP", "CTR" };
+		static const char* const Airports[] = { "EDDF", "EDDM", "EDDL", "EDDH", "EDDK", "EDDS", "EDDB", "EDDN", "EDDV", "EDDW", "EDDP", "EDDC", "EDLW", "EDDG", "EDDR", "EDJA", "EDNY", "EDSB", "EDFH", "EDLP" };
+		json whosOnline;
+		whosOnline["Type"] = "WhosOnline";
+		whosOnline["Timestamp"] = "2020-08-01T12:00:00Z";
+		int n = 0;
+		for (const char* airport : Airports)
+		{
+			for (const char* facility : Facilities)
+			{
+				json station;
+				station["Callsign"] = std::string(airport) + "_" + facility;
+				const int khz = 118000 + (n * 275) % 18000;
+				station["Frequency"] = std::to_string(khz / 1000) + "." + std::to_string(khz % 1000 + 1000).substr(1);
+				station["XplaneFrequency"] = khz / 10;
+				station["RealName"] = "Controller " + std::to_string(1000000 + n * 7919);
+				whosOnline["Data"].push_back(station);
+				n++;
+			}
+		}
+		payloads.push_back({ "WhosOnline x120", whosOnline.dump() });
+
+		return payloads;
+	}
+
+	struct Result
+	{
+		size_t wireBytes = 0;
+		std::vector<long long> latencies;
+	};
+
+	double Percentile(std::vector<long long> values, double p)
+	{
+		if (values.empty())
+			return 0.0;
+		std::sort(values.begin(), values.end());
+		return static_cast<double>(values[static_cast<size_t>(p * (values.size() - 1))]);
+	}
+
+	void Print(const Payload& payload, const char* direction, bool lz4, const Result& result)
+	{
+		printf("%-18s %-8s %-5s %8zu B %8zu B %6.1f%% %9.1f us %9.1f us\n", payload.name, direction, lz4 ? "lz4" : "none",
+			payload.message.size(), result.wireBytes, 100.0 * result.wireBytes / payload.message.size(),
+			Percentile(result.latencies, 0.50), Percentile(result.latencies, 0.99));
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const int iterations = argc > 1 ? atoi(argv[1]) : 1000;
+	const std::string port = argc > 2 ? argv[2] : "45099";
+	const std::string endpoint = "tcp://127.0.0.1:" + port;
+
+	// what the plugin does with an inbound message: parse it, stamp when that was done
+	std::atomic<long long> handledAt{ 0 };
+	std::atomic<uint64_t> handled{ 0 };
+	ZmqReactor reactor([&](const std::string& msg)
+	{
+		json j = json::parse(msg);
+		handledAt = Now();
+		handled++;
+	});
+
+	if (!reactor.start(endpoint))
+	{
+		AsyncLog::Instance().flushAll();
+		fprintf(stderr, "could not bind %s\n", endpoint.c_str());
+		return 1;
+	}
+
+	zmq::context_t context(1);
+	zmq::socket_t dealer(context, ZMQ_DEALER);
+	dealer.setsockopt(ZMQ_IDENTITY, "CLIENT", 6);
+	dealer.setsockopt(ZMQ_LINGER, 0);
+	dealer.connect(endpoint);
+
+	// the ROUTER only sends to peers it has heard from
+	dealer.send(zmq::message_t("{}", 2), zmq::send_flags::none);
+	while (handled == 0)
+	{
+		std::this_thread::yield();
+	}
+
+	const auto waitHandled = [&](uint64_t count)
+	{
+		while (handled < count)
+		{
+			std::this_thread::yield();
+		}
+	};
+
+	printf("%d iterations per row, one message in flight\n\n", iterations);
+	printf("%-18s %-8s %-5s %10s %10s %7s %12s %12s\n", "payload", "dir", "comp", "raw", "wire", "ratio", "p50", "p99");
+
+	std::string frame;
+	for (const Payload& payload : Payloads())
+	{
+		for (bool lz4 : { false, true })
+		{
+			// client -> plugin: compressed by the client, decompressed and parsed by the reactor
+			Result inbound;
+			for (int i = 0; i < iterations; i++)
+			{
+				const uint64_t expected = handled + 1;
+				const long long begin = Now();
+				const bool compressed = lz4 && payload.message.size() >= DefaultCompressionThreshold && CompressFrame(payload.message, frame);
+				const std::string& wire = compressed ? frame : payload.message;
+				dealer.send(zmq::message_t(wire.data(), wire.size()), zmq::send_flags::none);
+				waitHandled(expected);
+				inbound.latencies.push_back(handledAt - begin);
+				inbound.wireBytes = wire.size();
+			}
+			Print(payload, "in", lz4, inbound);
+
+			// plugin -> client: compressed by the reactor as negotiated, decompressed and parsed by the client
+			reactor.setCompression(lz4);
+			Result outbound;
+			for (int i = 0; i < iterations; i++)
+			{
+				const long long begin = Now();
+				reactor.send(payload.message);
+
+				zmq::message_t msg;
+				if (!dealer.recv(msg, zmq::recv_flags::none))
+					break;
+
+				std::string decompressed;
+				if (IsCompressedFrame(msg.data(), msg.size()))
+				{
+					DecompressFrame(msg.data(), msg.size(), decompressed);
+				}
+				else
+				{
+					decompressed.assign(msg.data<char>(), msg.size());
+				}
+				json j = json::parse(decompressed);
+				outbound.latencies.push_back(Now() - begin);
+				outbound.wireBytes = msg.size();
+			}
+			Print(payload, "out", lz4, outbound);
+		}
+	}
+
+	dealer.close();
+	context.close();
+	reactor.stop();
+	AsyncLog::Instance().flushAll();
+	return 0;
+}
@@ -0,0 +1,706 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <dirent.h>
+#include <unistd.h>
+
+#include "HeadlessSim.h"
+
+#include "XPLMCamera.h"
+#include "XPLMDataAccess.h"
+#include "XPLMGraphics.h"
+#include "XPLMPlugin.h"
+#include "XPLMProcessing.h"
+#include "XPLMScenery.h"
+#include "XPLMUtilities.h"
+
+namespace
+{
+	constexpr double MetersPerDegree = 111120.0;
+	constexpr double RadiansPerDegree = 3.14159265358979323846 / 180.0;
+
+	struct DataRef
+	{
+		std::string name;
+		XPLMDataTypeID types = xplmType_Int | xplmType_Float | xplmType_Double | xplmType_IntArray | xplmType_FloatArray | xplmType_Data;
+		bool writable = true;
+
+		// set while a plugin provides the dataref through XPLMRegisterDataAccessor
+		bool owned = false;
+		XPLMGetDatai_f readInt = nullptr;
+		XPLMSetDatai_f writeInt = nullptr;
+		XPLMGetDataf_f readFloat = nullptr;
+		XPLMSetDataf_f writeFloat = nullptr;
+		XPLMGetDatad_f readDouble = nullptr;
+		XPLMSetDatad_f writeDouble = nullptr;
+		XPLMGetDatavi_f readIntArray = nullptr;
+		XPLMSetDatavi_f writeIntArray = nullptr;
+		XPLMGetDatavf_f readFloatArray = nullptr;
+		XPLMSetDatavf_f writeFloatArray = nullptr;
+		XPLMGetDatab_f readData = nullptr;
+		XPLMSetDatab_f writeData = nullptr;
+		void* readRefcon = nullptr;
+		void* writeRefcon = nullptr;
+
+		// what X-Plane would hold otherwise
+		double value = 0.0;
+		std::vector<int> ints;
+		std::vector<float> floats;
+		std::vector<char> bytes;
+	};
+
+	struct FlightLoop
+	{
+		XPLMFlightLoop_f callback = nullptr;
+		void* refcon = nullptr;
+		bool scheduled = false;
+		bool removed = false;
+		float nextTime = 0.0f; // when the interval is in seconds
+		int nextFrame = 0;     // when the interval is in frames
+		bool inFrames = false;
+		float lastCall = 0.0f;
+	};
+
+	struct SimState
+	{
+		std::unordered_map<std::string, std::unique_ptr<DataRef>> dataRefs;
+		std::vector<std::unique_ptr<FlightLoop>> flightLoops;
+
+		float elapsedTime = 0.0f;
+		float lastFrameTime = 0.0f;
+		int frame = 0;
+
+		xpilot::HeadlessSim::Heightfield heightfield = [](double latitude, double longitude)
+		{
+			return 100.0 + 30.0 * std::sin(latitude * 40.0) * std::cos(longitude * 40.0);
+		};
+		uint64_t probes = 0;
+
+		// origin of the local coordinates, and the camera
+		double originLatitude = 0.0;
+		double originLongitude = 0.0;
+		double cameraLatitude = 0.0;
+		double cameraLongitude = 0.0;
+		double cameraAltitude = 0.0;
+	};
+
+	SimState& Sim()
+	{
+		static SimState sim;
+		return sim;
+	}
+
+	DataRef* FindOrCreate(const char* name)
+	{
+		auto& refs = Sim().dataRefs;
+		auto it = refs.find(name);
+		if (it == refs.end())
+		{
+			auto ref = std::make_unique<DataRef>();
+			ref->name = name;
+			it = refs.emplace(name, std::move(ref)).first;
+		}
+		return it->second.get();
+	}
+
+	float ReadNetworkTime(void*)
+	{
+		return Sim().elapsedTime;
+	}
+
+	void Schedule(FlightLoop& loop, float interval)
+	{
+		const SimState& sim = Sim();
+		loop.scheduled = interval < 0.0f || interval > 0.0f;
+		loop.inFrames = interval < 0.0f;
+		loop.nextTime = sim.elapsedTime + interval;
+		loop.nextFrame = sim.frame + static_cast<int>(-interval);
+	}
+
+	FlightLoop* FindFlightLoop(XPLMFlightLoop_f callback, void* refcon)
+	{
+		for (const auto& loop : Sim().flightLoops)
+		{
+			if (!loop->removed && loop->callback == callback && loop->refcon == refcon)
+				return loop.get();
+		}
+		return nullptr;
+	}
+
+	template<typename T>
+	int CopyArray(const std::vector<T>& values, T* out, int offset, int max)
+	{
+		const int size = static_cast<int>(values.size());
+		if (!out)
+			return size;
+		const int count = std::max(0, std::min(max, size - offset));
+		std::copy_n(values.begin() + std::min(offset, size), count, out);
+		return count;
+	}
+
+	template<typename T>
+	void StoreArray(std::vector<T>& values, const T* in, int offset, int count)
+	{
+		if (count <= 0)
+			return;
+		if (values.size() < static_cast<size_t>(offset + count))
+		{
+			values.resize(offset + count);
+		}
+		std::copy_n(in, count, values.begin() + offset);
+	}
+}
+
+namespace xpilot
+{
+	void HeadlessSim::setHeightfield(const Heightfield& heightfield)
+	{
+		Sim().heightfield = heightfield;
+	}
+
+	void HeadlessSim::setCamera(double latitude, double longitude, double altitudeMeters)
+	{
+		SimState& sim = Sim();
+		sim.originLatitude = sim.cameraLatitude = latitude;
+		sim.originLongitude = sim.cameraLongitude = longitude;
+		sim.cameraAltitude = altitudeMeters;
+	}
+
+	void HeadlessSim::runFrame(float elapsed)
+	{
+		SimState& sim = Sim();
+		sim.elapsedTime += elapsed;
+		sim.frame++;
+
+		// loops registered during this frame first run in the next one
+		const size_t count = sim.flightLoops.size();
+		for (size_t i = 0; i < count; i++)
+		{
+			FlightLoop& loop = *sim.flightLoops[i];
+			if (loop.removed || !loop.scheduled)
+				continue;
+			if (loop.inFrames ? sim.frame < loop.nextFrame : sim.elapsedTime < loop.nextTime)
+				continue;
+
+			const float sinceLastCall = sim.elapsedTime - loop.lastCall;
+			loop.lastCall = sim.elapsedTime;
+			const float next = loop.callback(sinceLastCall, sim.elapsedTime - sim.lastFrameTime, sim.frame, loop.refcon);
+			if (!loop.removed)
+			{
+				Schedule(loop, next);
+			}
+		}
+		sim.lastFrameTime = sim.elapsedTime;
+
+		sim.flightLoops.erase(std::remove_if(sim.flightLoops.begin(), sim.flightLoops.end(),
+			[](const std::unique_ptr<FlightLoop>& loop) { return loop->removed; }), sim.flightLoops.end());
+	}
+
+	float HeadlessSim::elapsedTime()
+	{
+		return Sim().elapsedTime;
+	}
+
+	int HeadlessSim::frameCount()
+	{
+		return Sim().frame;
+	}
+
+	uint64_t HeadlessSim::probeCount()
+	{
+		return Sim().probes;
+	}
+
+	void HeadlessSim::setDatai(const char* name, int value)
+	{
+		XPLMSetDatai(XPLMFindDataRef(name), value);
+	}
+
+	void HeadlessSim::setDataf(const char* name, float value)
+	{
+		XPLMSetDataf(XPLMFindDataRef(name), value);
+	}
+
+	void HeadlessSim::setDatad(const char* name, double value)
+	{
+		XPLMSetDatad(XPLMFindDataRef(name), value);
+	}
+}
+
+// ---------------------------------------------------------------------------------------
+// XPLMDataAccess
+
+XPLMDataRef XPLMFindDataRef(const char* inDataRefName)
+{
+	static bool builtIns = false;
+	if (!builtIns)
+	{
+		builtIns = true;
+		XPLMRegisterDataAccessor("sim/network/misc/network_time_sec", xplmType_Float, 0,
+			nullptr, nullptr, ReadNetworkTime, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr);
+		XPLMRegisterDataAccessor("sim/time/total_running_time_sec", xplmType_Float, 0,
+			nullptr, nullptr, ReadNetworkTime, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr);
+	}
+	return FindOrCreate(inDataRefName);
+}
+
+int XPLMCanWriteDataRef(XPLMDataRef inDataRef)
+{
+	return inDataRef && static_cast<DataRef*>(inDataRef)->writable;
+}
+
+int XPLMIsDataRefGood(XPLMDataRef inDataRef)
+{
+	return inDataRef != nullptr;
+}
+
+XPLMDataTypeID XPLMGetDataRefTypes(XPLMDataRef inDataRef)
+{
+	return inDataRef ? static_cast<DataRef*>(inDataRef)->types : xplmType_Unknown;
+}
+
+int XPLMGetDatai(XPLMDataRef inDataRef)
+{
+	const DataRef* ref = static_cast<DataRef*>(inDataRef);
+	if (!ref) return 0;
+	if (ref->owned)
+	{
+		if (ref->readInt) return ref->readInt(ref->readRefcon);
+		if (ref->readFloat) return static_cast<int>(ref->readFloat(ref->readRefcon));
+		if (ref->readDouble) return static_cast<int>(ref->readDouble(ref->readRefcon));
+		return 0;
+	}
+	return static_cast<int>(ref->value);
+}
+
+void XPLMSetDatai(XPLMDataRef inDataRef, int inValue)
+{
+	DataRef* ref = static_cast<DataRef*>(inDataRef);
+	if (!ref) return;
+	if (!ref->owned)
+	{
+		ref->value = inValue;
+	}
+	else if (ref->writeInt)
+	{
+		ref->writeInt(ref->writeRefcon, inValue);
+	}
+}
+
+float XPLMGetDataf(XPLMDataRef inDataRef)
+{
+	const DataRef* ref = static_cast<DataRef*>(inDataRef);
+	if (!ref) return 0.0f;
+	if (ref->owned)
+	{
+		if (ref->readFloat) return ref->readFloat(ref->readRefcon);
+		if (ref->readDouble) return static_cast<float>(ref->readDouble(ref->readRefcon));
+		if (ref->readInt) return static_cast<float>(ref->readInt(ref->readRefcon));
+		return 0.0f;
+	}
+	return static_cast<float>(ref->value);
+}
+
+void XPLMSetDataf(XPLMDataRef inDataRef, float inValue)
+{
+	DataRef* ref = static_cast<DataRef*>(inDataRef);
+	if (!ref) return;
+	if (!ref->owned)
+	{
+		ref->value = inValue;
+	}
+	else if (ref->writeFloat)
+	{
+		ref->writeFloat(ref->writeRefcon, inValue);
+	}
+}
+
+double XPLMGetDatad(XPLMDataRef inDataRef)
+{
+	const DataRef* ref = static_cast<DataRef*>(inDataRef);
+	if (!ref) return 0.0;
+	if (ref->owned)
+	{
+		if (ref->readDouble) return ref->readDouble(ref->readRefcon);
+		if (ref->readFloat) return ref->readFloat(ref->readRefcon);
+		if (ref->readInt) return ref->readInt(ref->readRefcon);
+		return 0.0;
+	}
+	return ref->value;
+}
+
+void XPLMSetDatad(XPLMDataRef inDataRef, double inValue)
+{
+	DataRef* ref = static_cast<DataRef*>(inDataRef);
+	if (!ref) return;
+	if (!ref->owned)
+	{
+		ref->value = inValue;
+	}
+	else if (ref->writeDouble)
+	{
+		ref->writeDouble(ref->writeRefcon, inValue);
+	}
+}
+
+int XPLMGetDatavi(XPLMDataRef inDataRef, int* outValues, int inOffset, int inMax)
+{
+	DataRef* ref = static_cast<DataRef*>(inDataRef);
+	if (!ref) return 0;
+	if (ref->owned)
+		return ref->readIntArray ? ref->readIntArray(ref->readRefcon, outValues, inOffset, inMax) : 0;
+	return CopyArray(ref->ints, outValues, inOffset, inMax);
+}
+
+void XPLMSetDatavi(XPLMDataRef inDataRef, int* inValues, int inoffset, int inCount)
+{
+	DataRef* ref = static_cast<DataRef*>(inDataRef);
+	if (!ref) return;
+	if (!ref->owned)
+	{
+		StoreArray(ref->ints, inValues, inoffset, inCount);
+	}
+	else if (ref->writeIntArray)
+	{
+		ref->writeIntArray(ref->writeRefcon, inValues, inoffset, inCount);
+	}
+}
+
+int XPLMGetDatavf(XPLMDataRef inDataRef, float* outValues, int inOffset, int inMax)
+{
+	DataRef* ref = static_cast<DataRef*>(inDataRef);
+	if (!ref) return 0;
+	if (ref->owned)
+		return ref->readFloatArray ? ref->readFloatArray(ref->readRefcon, outValues, inOffset, inMax) : 0;
+	return CopyArray(ref->floats, outValues, inOffset, inMax);
+}
+
+void XPLMSetDatavf(XPLMDataRef inDataRef, float* inValues, int inoffset, int inCount)
+{
+	DataRef* ref = static_cast<DataRef*>(inDataRef);
+	if (!ref) return;
+	if (!ref->owned)
+	{
+		StoreArray(ref->floats, inValues, inoffset, inCount);
+	}
+	else if (ref->writeFloatArray)
+	{
+		ref->writeFloatArray(ref->writeRefcon, inValues, inoffset, inCount);
+	}
+}
+
+int XPLMGetDatab(XPLMDataRef inDataRef, void* outValue, int inOffset, int inMaxBytes)
+{
+	DataRef* ref = static_cast<DataRef*>(inDataRef);
+	if (!ref) return 0;
+	if (ref->owned)
+		return ref->readData ? ref->readData(ref->readRefcon, outValue, inOffset, inMaxBytes) : 0;
+	return CopyArray(ref->bytes, static_cast<char*>(outValue), inOffset, inMaxBytes);
+}
+
+void XPLMSetDatab(XPLMDataRef inDataRef, void* inValue, int inOffset, int inLength)
+{
+	DataRef* ref = static_cast<DataRef*>(inDataRef);
+	if (!ref) return;
+	if (!ref->owned)
+	{
+		StoreArray(ref->bytes, static_cast<const char*>(inValue), inOffset, inLength);
+	}
+	else if (ref->writeData)
+	{
+		ref->writeData(ref->writeRefcon, inValue, inOffset, inLength);
+	}
+}
+
+XPLMDataRef XPLMRegisterDataAccessor(const char* inDataName, XPLMDataTypeID inDataType, int inIsWritable,
+	XPLMGetDatai_f inReadInt, XPLMSetDatai_f inWriteInt,
+	XPLMGetDataf_f inReadFloat, XPLMSetDataf_f inWriteFloat,
+	XPLMGetDatad_f inReadDouble, XPLMSetDatad_f inWriteDouble,
+	XPLMGetDatavi_f inReadIntArray, XPLMSetDatavi_f inWriteIntArray,
+	XPLMGetDatavf_f inReadFloatArray, XPLMSetDatavf_f inWriteFloatArray,
+	XPLMGetDatab_f inReadData, XPLMSetDatab_f inWriteData,
+	void* inReadRefcon, void* inWriteRefcon)
+{
+	DataRef* ref = FindOrCreate(inDataName);
+	ref->types = inDataType;
+	ref->writable = inIsWritable != 0;
+	ref->owned = true;
+	ref->readInt = inReadInt;
+	ref->writeInt = inWriteInt;
+	ref->readFloat = inReadFloat;
+	ref->writeFloat = inWriteFloat;
+	ref->readDouble = inReadDouble;
+	ref->writeDouble = inWriteDouble;
+	ref->readIntArray = inReadIntArray;
+	ref->writeIntArray = inWriteIntArray;
+	ref->readFloatArray = inReadFloatArray;
+	ref->writeFloatArray = inWriteFloatArray;
+	ref->readData = inReadData;
+	ref->writeData = inWriteData;
+	ref->readRefcon = inReadRefcon;
+	ref->writeRefcon = inWriteRefcon;
+	return ref;
+}
+
+void XPLMUnregisterDataAccessor(XPLMDataRef inDataRef)
+{
+	DataRef* ref = static_cast<DataRef*>(inDataRef);
+	if (!ref) return;
+
+	// the handle stays valid, reading it just yields nothing from now on
+	const std::string name = ref->name;
+	*ref = DataRef();
+	ref->name = name;
+	ref->owned = true;
+}
+
+int XPLMShareData(const char*, XPLMDataTypeID, XPLMDataChanged_f, void*)
+{
+	return 1;
+}
+
+int XPLMUnshareData(const char*, XPLMDataTypeID, XPLMDataChanged_f, void*)
+{
+	return 1;
+}
+
+// ---------------------------------------------------------------------------------------
+// XPLMProcessing
+
+float XPLMGetElapsedTime(void)
+{
+	return Sim().elapsedTime;
+}
+
+int XPLMGetCycleNumber(void)
+{
+	return Sim().frame;
+}
+
+void XPLMRegisterFlightLoopCallback(XPLMFlightLoop_f inFlightLoop, float inInterval, void* inRefcon)
+{
+	auto loop = std::make_unique<FlightLoop>();
+	loop->callback = inFlightLoop;
+	loop->refcon = inRefcon;
+	loop->lastCall = Sim().elapsedTime;
+	Schedule(*loop, inInterval);
+	Sim().flightLoops.push_back(std::move(loop));
+}
+
+void XPLMUnregisterFlightLoopCallback(XPLMFlightLoop_f inFlightLoop, void* inRefcon)
+{
+	if (FlightLoop* loop = FindFlightLoop(inFlightLoop, inRefcon))
+	{
+		loop->removed = true;
+	}
+}
+
+void XPLMSetFlightLoopCallbackInterval(XPLMFlightLoop_f inFlightLoop, float inInterval, int, void* inRefcon)
+{
+	if (FlightLoop* loop = FindFlightLoop(inFlightLoop, inRefcon))
+	{
+		Schedule(*loop, inInterval);
+	}
+}
+
+XPLMFlightLoopID XPLMCreateFlightLoop(XPLMCreateFlightLoop_t* inParams)
+{
+	auto loop = std::make_unique<FlightLoop>();
+	loop->callback = inParams->callbackFunc;
+	loop->refcon = inParams->refcon;
+	loop->lastCall = Sim().elapsedTime;
+	FlightLoop* id = loop.get();
+	Sim().flightLoops.push_back(std::move(loop));
+	return id;
+}
+
+void XPLMDestroyFlightLoop(XPLMFlightLoopID inFlightLoopID)
+{
+	static_cast<FlightLoop*>(inFlightLoopID)->removed = true;
+}
+
+void XPLMScheduleFlightLoop(XPLMFlightLoopID inFlightLoopID, float inInterval, int)
+{
+	Schedule(*static_cast<FlightLoop*>(inFlightLoopID), inInterval);
+}
+
+// ---------------------------------------------------------------------------------------
+// XPLMGraphics, XPLMScenery, XPLMCamera
+//
+// Local coordinates are an equirectangular projection around the origin set by
+// HeadlessSim::setCamera: x east, y up (meters MSL), z south.
+
+void XPLMWorldToLocal(double inLatitude, double inLongitude, double inAltitude, double* outX, double* outY, double* outZ)
+{
+	const SimState& sim = Sim();
+	*outX = (inLongitude - sim.originLongitude) * MetersPerDegree * std::cos(inLatitude * RadiansPerDegree);
+	*outY = inAltitude;
+	*outZ = -(inLatitude - sim.originLatitude) * MetersPerDegree;
+}
+
+void XPLMLocalToWorld(double inX, double inY, double inZ, double* outLatitude, double* outLongitude, double* outAltitude)
+{
+	const SimState& sim = Sim();
+	const double latitude = sim.originLatitude - inZ / MetersPerDegree;
+	*outLatitude = latitude;
+	*outLongitude = sim.originLongitude + inX / (MetersPerDegree * std::cos(latitude * RadiansPerDegree));
+	*outAltitude = inY;
+}
+
+XPLMProbeRef XPLMCreateProbe(XPLMProbeType)
+{
+	return new int(0);
+}
+
+void XPLMDestroyProbe(XPLMProbeRef inProbe)
+{
+	delete static_cast<int*>(inProbe);
+}
+
+XPLMProbeResult XPLMProbeTerrainXYZ(XPLMProbeRef, float inX, float, float inZ, XPLMProbeInfo_t* outInfo)
+{
+	SimState& sim = Sim();
+	sim.probes++;
+
+	double latitude, longitude, altitude;
+	XPLMLocalToWorld(inX, 0.0, inZ, &latitude, &longitude, &altitude);
+	const double elevation = sim.heightfield(latitude, longitude);
+	if (std::isnan(elevation))
+		return xplm_ProbeMissed;
+
+	outInfo->locationX = inX;
+	outInfo->locationY = static_cast<float>(elevation);
+	outInfo->locationZ = inZ;
+	outInfo->normalX = 0.0f;
+	outInfo->normalY = 1.0f;
+	outInfo->normalZ = 0.0f;
+	outInfo->velocityX = 0.0f;
+	outInfo->velocityY = 0.0f;
+	outInfo->velocityZ = 0.0f;
+	outInfo->is_wet = 0;
+	return xplm_ProbeHitTerrain;
+}
+
+void XPLMReadCameraPosition(XPLMCameraPosition_t* outCameraPosition)
+{
+	const SimState& sim = Sim();
+	double x, y, z;
+	XPLMWorldToLocal(sim.cameraLatitude, sim.cameraLongitude, sim.cameraAltitude, &x, &y, &z);
+	outCameraPosition->x = static_cast<float>(x);
+	outCameraPosition->y = static_cast<float>(y);
+	outCameraPosition->z = static_cast<float>(z);
+	outCameraPosition->pitch = 0.0f;
+	outCameraPosition->heading = 0.0f;
+	outCameraPosition->roll = 0.0f;
+	outCameraPosition->zoom = 1.0f;
+}
+
+// ---------------------------------------------------------------------------------------
+// XPLMPlugin, XPLMUtilities
+
+XPLMPluginID XPLMGetMyID(void)
+{
+	return 1;
+}
+
+void XPLMGetPluginInfo(XPLMPluginID, char* outName, char* outFilePath, char* outSignature, char* outDescription)
+{
+	// the plugin seems to live in <working directory>/64, so its resources are found in the working directory
+	char cwd[1024] = "";
+	if (!getcwd(cwd, sizeof(cwd))) cwd[0] = 0;
+	if (outName) strcpy(outName, "xPilot");
+	if (outFilePath) snprintf(outFilePath, 256, "%s/64/lin.xpl", cwd);
+	if (outSignature) strcpy(outSignature, "vatsim.xpilot");
+	if (outDescription) strcpy(outDescription, "xPilot (headless)");
+}
+
+XPLMPluginID XPLMFindPluginBySignature(const char*)
+{
+	return XPLM_NO_PLUGIN_ID;
+}
+
+void XPLMSendMessageToPlugin(XPLMPluginID, int, void*)
+{
+}
+
+void XPLMDebugString(const char* inString)
+{
+	fputs(inString, stderr);
+}
+
+void XPLMGetSystemPath(char* outSystemPath)
+{
+	if (!getcwd(outSystemPath, 512)) outSystemPath[0] = 0;
+	strcat(outSystemPath, "/");
+}
+
+const char* XPLMGetDirectorySeparator(void)
+{
+	return "/";
+}
+
+char* XPLMExtractFileAndPath(char* inFullPath)
+{
+	char* separator = strrchr(inFullPath, '/');
+	if (!separator)
+		return inFullPath;
+	*separator = 0;
+	return separator + 1;
+}
+
+int XPLMGetDirectoryContents(const char* inDirectoryPath, int inFirstReturn, char* outFileNames, int inFileNameBufSize,
+	char** outIndices, int inIndexCount, int* outTotalFiles, int* outReturnedFiles)
+{
+	std::vector<std::string> names;
+	if (DIR* dir = opendir(inDirectoryPath))
+	{
+		while (dirent* entry = readdir(dir))
+		{
+			names.push_back(entry->d_name);
+		}
+		closedir(dir);
+	}
+	std::sort(names.begin(), names.end());
+
+	int returned = 0;
+	int used = 0;
+	for (size_t i = inFirstReturn; i < names.size(); i++)
+	{
+		const int size = static_cast<int>(names[i].size()) + 1;
+		if ((outIndices && returned >= inIndexCount) || used + size > inFileNameBufSize)
+			break;
+		memcpy(outFileNames + used, names[i].c_str(), size);
+		if (outIndices) outIndices[returned] = outFileNames + used;
+		used += size;
+		returned++;
+	}
+
+	if (outTotalFiles) *outTotalFiles = static_cast<int>(names.size());
+	if (outReturnedFiles) *outReturnedFiles = returned;
+	return inFirstReturn + returned >= static_cast<int>(names.size()) ? 1 : 0;
+}
@@ -0,0 +1,388 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include <cmath>
+#include <deque>
+#include <map>
+#include <string>
+
+#include "HeadlessSim.h"
+
+#include "XPLMGraphics.h"
+#include "XPLMProcessing.h"
+#include "XPMPAircraft.h"
+#include "XPMPMultiplayer.h"
+
+namespace XPMP2
+{
+	class CSLModel
+	{
+	public:
+		std::string cslId;
+		std::string icaoType;
+		std::string airline;
+		std::string livery;
+	};
+
+	void AIMultiUpdate();
+}
+
+namespace
+{
+	struct Stub
+	{
+		std::deque<XPMP2::CSLModel> models; // stable addresses, Aircraft keeps a pointer
+		std::map<std::string, XPMP2::CSLModel*> modelsById;
+		std::map<XPMPPlaneID, XPMP2::Aircraft*> aircraft;
+		std::string defaultIcao = "A320";
+		XPMPPlaneID nextId = 0x00FFFFFF;
+		uint64_t matches = 0;
+		XPLMFlightLoopID flightLoop = nullptr;
+	};
+
+	Stub& State()
+	{
+		static Stub stub;
+		return stub;
+	}
+
+	XPMP2::CSLModel* AddModel(const std::string& cslId, const std::string& icaoType, const std::string& airline, const std::string& livery)
+	{
+		Stub& stub = State();
+		auto it = stub.modelsById.find(cslId);
+		if (it != stub.modelsById.end())
+			return it->second;
+
+		stub.models.push_back({ cslId, icaoType, airline, livery });
+		XPMP2::CSLModel* model = &stub.models.back();
+		stub.modelsById[cslId] = model;
+		return model;
+	}
+
+	// Best match first, like XPMP2: type, airline and livery, then type and airline, then
+	// type alone. Without a model for the type, one is made up for it.
+	XPMP2::CSLModel* MatchModel(const std::string& icaoType, const std::string& airline, const std::string& livery, int& quality)
+	{
+		Stub& stub = State();
+		stub.matches++;
+
+		const std::string type = icaoType.empty() ? stub.defaultIcao : icaoType;
+		XPMP2::CSLModel* byAirline = nullptr;
+		XPMP2::CSLModel* byType = nullptr;
+		for (auto& model : stub.models)
+		{
+			if (model.icaoType != type)
+				continue;
+			if (model.airline == airline && model.livery == livery)
+			{
+				quality = 0;
+				return &model;
+			}
+			if (!byAirline && !airline.empty() && model.airline == airline)
+				byAirline = &model;
+			if (!byType)
+				byType = &model;
+		}
+
+		if (byAirline)
+		{
+			quality = 1;
+			return byAirline;
+		}
+		if (byType)
+		{
+			quality = 2;
+			return byType;
+		}
+		quality = 3;
+		return AddModel("Headless/" + type, type, "", "");
+	}
+
+	float FlightLoop(float elapsedSinceLastCall, float, int counter, void*)
+	{
+		XPMP2::AIMultiUpdate();
+
+		// UpdatePosition may not add or remove aircraft; no copy, it would allocate for every
+		// aircraft on every frame and show up in the allocation counts of the benchmark
+		for (const auto& entry : State().aircraft)
+		{
+			XPMP2::Aircraft* plane = entry.second;
+			if (plane->IsValid())
+			{
+				plane->UpdatePosition(elapsedSinceLastCall, counter);
+			}
+		}
+		return -1.0f;
+	}
+}
+
+namespace XPMP2
+{
+	CSLModelInfo_t::CSLModelInfo_t(const CSLModel& csl) :
+		cslId(csl.cslId),
+		modelName(csl.cslId.substr(csl.cslId.find('/') + 1)),
+		icaoType(csl.icaoType)
+	{
+		vecMatchCrit.push_back({ csl.airline, csl.livery });
+	}
+
+	// Stands in for XPMP2's TCAS/AI update: the camera distance is all the stub keeps.
+	void AIMultiUpdate()
+	{
+		XPLMCameraPosition_t camera;
+		XPLMReadCameraPosition(&camera);
+		for (const auto& entry : State().aircraft)
+		{
+			Aircraft* plane = entry.second;
+			const float dx = plane->drawInfo.x - camera.x;
+			const float dy = plane->drawInfo.y - camera.y;
+			const float dz = plane->drawInfo.z - camera.z;
+			plane->camDist = std::sqrt(dx * dx + dy * dy + dz * dz);
+			plane->camTimLstUpd = XPLMGetElapsedTime();
+		}
+	}
+
+	Aircraft::Aircraft(const std::string& _icaoType, const std::string& _icaoAirline, const std::string& _livery, XPMPPlaneID _modeS_id, const std::string& _cslId)
+	{
+		drawInfo = XPLMDrawInfo_t();
+		drawInfo.structSize = sizeof(drawInfo);
+		v.resize(V_COUNT, 0.0f);
+		Create(_icaoType, _icaoAirline, _livery, _modeS_id, _cslId);
+	}
+
+	Aircraft::Aircraft()
+	{
+		drawInfo = XPLMDrawInfo_t();
+		drawInfo.structSize = sizeof(drawInfo);
+		v.resize(V_COUNT, 0.0f);
+	}
+
+	Aircraft::~Aircraft()
+	{
+		State().aircraft.erase(modeS_id);
+	}
+
+	void Aircraft::Create(const std::string& _icaoType, const std::string& _icaoAirline, const std::string& _livery, XPMPPlaneID _modeS_id, const std::string& _cslId, CSLModel* _pCSLModel)
+	{
+		Stub& stub = State();
+		if (!_modeS_id)
+		{
+			while (stub.aircraft.count(++stub.nextId)) {}
+			_modeS_id = stub.nextId;
+		}
+		if (stub.aircraft.count(_modeS_id))
+			throw std::logic_error("Duplicate modeS_id " + std::to_string(_modeS_id));
+
+		modeS_id = _modeS_id;
+		stub.aircraft[modeS_id] = this;
+
+		acIcaoType = _icaoType;
+		acIcaoAirline = _icaoAirline;
+		acLivery = _livery;
+		if (!AssignModel(_cslId, _pCSLModel))
+		{
+			pCSLMdl = MatchModel(acIcaoType, acIcaoAirline, acLivery, matchQuality);
+		}
+	}
+
+	int Aircraft::ChangeModel(const std::string& _icaoType, const std::string& _icaoAirline, const std::string& _livery)
+	{
+		acIcaoType = _icaoType;
+		acIcaoAirline = _icaoAirline;
+		acLivery = _livery;
+		pCSLMdl = MatchModel(acIcaoType, acIcaoAirline, acLivery, matchQuality);
+		return matchQuality;
+	}
+
+	bool Aircraft::AssignModel(const std::string& _cslId, CSLModel* _pCSLModel)
+	{
+		if (!_pCSLModel)
+		{
+			auto it = State().modelsById.find(_cslId);
+			if (it == State().modelsById.end())
+				return false;
+			_pCSLModel = it->second;
+		}
+		pCSLMdl = _pCSLModel;
+		matchQuality = 0;
+		return true;
+	}
+
+	const std::string& Aircraft::GetModelName() const
+	{
+		static const std::string none;
+		return pCSLMdl ? pCSLMdl->cslId : none;
+	}
+
+	std::string Aircraft::GetFlightId() const
+	{
+		return label;
+	}
+
+	void Aircraft::SetInvalid()
+	{
+		bValid = false;
+	}
+
+	void Aircraft::SetVisible(bool _bVisible)
+	{
+		bVisible = _bVisible;
+	}
+
+	void Aircraft::SetRender(bool _bRender)
+	{
+		bRender = _bRender;
+	}
+
+	void Aircraft::ComputeMapLabel()
+	{
+		mapLabel = label;
+	}
+
+	void Aircraft::SetLocation(double lat, double lon, double alt_ft)
+	{
+		double x, y, z;
+		XPLMWorldToLocal(lat, lon, alt_ft * M_per_FT, &x, &y, &z);
+		drawInfo.x = static_cast<float>(x);
+		drawInfo.y = static_cast<float>(y);
+		drawInfo.z = static_cast<float>(z);
+	}
+
+	void Aircraft::GetLocation(double& lat, double& lon, double& alt_ft) const
+	{
+		XPLMLocalToWorld(drawInfo.x, drawInfo.y, drawInfo.z, &lat, &lon, &alt_ft);
+		alt_ft /= M_per_FT;
+	}
+
+	void Aircraft::SetEngineRotAngle(float _deg)
+	{
+		v[V_ENGINES_ENGINE_ROTATION_ANGLE_DEG] = _deg;
+		for (size_t i = 1; i <= 4; i++)
+		{
+			SetEngineRotAngle(i, _deg);
+		}
+	}
+
+	void Aircraft::SetEngineRotAngle(size_t idx, float _deg)
+	{
+		if (1 <= idx && idx <= 4)
+			v[V_ENGINES_ENGINE_ROTATION_ANGLE_DEG1 + idx - 1] = _deg;
+	}
+
+	void Aircraft::SetEngineRotRpm(float _rpm)
+	{
+		v[V_ENGINES_ENGINE_ROTATION_SPEED_RPM] = _rpm;
+		v[V_ENGINES_ENGINE_ROTATION_SPEED_RAD_SEC] = _rpm * RPM_to_RADs;
+		for (size_t i = 1; i <= 4; i++)
+		{
+			SetEngineRotRpm(i, _rpm);
+		}
+	}
+
+	void Aircraft::SetEngineRotRpm(size_t idx, float _rpm)
+	{
+		if (1 <= idx && idx <= 4)
+		{
+			v[V_ENGINES_ENGINE_ROTATION_SPEED_RPM1 + idx - 1] = _rpm;
+			v[V_ENGINES_ENGINE_ROTATION_SPEED_RAD_SEC1 + idx - 1] = _rpm * RPM_to_RADs;
+		}
+	}
+
+	void Aircraft::SetEngineRotRad(float _rad)
+	{
+		SetEngineRotRpm(_rad / RPM_to_RADs);
+	}
+
+	void Aircraft::SetEngineRotRad(size_t idx, float _rad)
+	{
+		SetEngineRotRpm(idx, _rad / RPM_to_RADs);
+	}
+
+	Aircraft* AcFindByID(XPMPPlaneID _id)
+	{
+		auto it = State().aircraft.find(_id);
+		return it == State().aircraft.end() ? nullptr : it->second;
+	}
+}
+
+const char* XPMPMultiplayerInit(const char*, const char*, XPMPIntPrefsFuncTy, const char* inDefaultICAO, const char*)
+{
+	Stub& stub = State();
+	if (inDefaultICAO && *inDefaultICAO)
+	{
+		stub.defaultIcao = inDefaultICAO;
+	}
+	if (!stub.flightLoop)
+	{
+		XPLMCreateFlightLoop_t params = { sizeof(XPLMCreateFlightLoop_t), xplm_FlightLoop_Phase_AfterFlightModel, FlightLoop, nullptr };
+		stub.flightLoop = XPLMCreateFlightLoop(&params);
+		XPLMScheduleFlightLoop(stub.flightLoop, -1.0f, 1);
+	}
+	return "";
+}
+
+void XPMPMultiplayerCleanup()
+{
+	Stub& stub = State();
+	if (stub.flightLoop)
+	{
+		XPLMDestroyFlightLoop(stub.flightLoop);
+		stub.flightLoop = nullptr;
+	}
+}
+
+const char* XPMPLoadCSLPackage(const char*)
+{
+	return "";
+}
+
+void XPMPSetDefaultPlaneICAO(const char* _acIcaoType, const char*)
+{
+	if (_acIcaoType && *_acIcaoType)
+	{
+		State().defaultIcao = _acIcaoType;
+	}
+}
+
+int XPMPGetNumberOfInstalledModels()
+{
+	return static_cast<int>(State().models.size());
+}
+
+long XPMPCountPlanes(void)
+{
+	return static_cast<long>(State().aircraft.size());
+}
+
+namespace xpilot
+{
+	void HeadlessSim::addModel(const std::string& cslId, const std::string& icaoType, const std::string& airline, const std::string& livery)
+	{
+		AddModel(cslId, icaoType, airline, livery);
+	}
+
+	size_t HeadlessSim::aircraftCount()
+	{
+		return State().aircraft.size();
+	}
+
+	uint64_t HeadlessSim::modelMatchCount()
+	{
+		return State().matches;
+	}
+}
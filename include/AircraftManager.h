@@ -19,12 +19,17 @@
 #ifndef AircraftManager_h
 #define AircraftManager_h
 
+#include <chrono>
 #include <string>
+#include <vector>
 #include <map>
 #include <mutex>
 
 #include "NetworkAircraftConfig.h"
 #include "NetworkAircraft.h"
+#include "Interpolation.h"
+#include "ClockOffsetEstimator.h"
+#include "ModelResidency.h"
 
 namespace xpilot
 {
@@ -39,17 +44,6 @@ namespace xpilot
 	}
 	mapPlanesTy::iterator mapGetAircraftByIndex(int idx);
 
-	inline double NormalizeHeading(double heading)
-	{
-		if (heading <= 0.0) {
-			heading += 360.0;
-		}
-		else if (heading > 360.0) {
-			heading -= 360.0;
-		}
-		return heading;
-	}
-
 	class AircraftManager
 	{
 	public:
@@ -58,11 +52,32 @@ namespace xpilot
 		void interpolateAirplanes();
 		void addNewPlane(const std::string& callsign, const std::string& typeIcao, const std::string& airlineIcao,
 			const std::string& livery = "", const std::string& modelName = "");
-		void setPlanePosition(const std::string& callsign, XPMPPlanePosition_t pos, XPMPPlaneRadar_t radar, float groundSpeed, const std::string& origin, const std::string& destination);
+		void setPlanePosition(const std::string& callsign, XPMPPlanePosition_t pos, XPMPPlaneRadar_t radar, float groundSpeed, const std::string& origin, const std::string& destination,
+			long long sourceTimestamp, long long receivedAt, long long dequeuedAt);
+		void setPlaneFastPosition(const std::string& callsign, VelocityState state, long long sourceTimestamp, long long receivedAt);
 		void updateAircraftConfig(const std::string& callsign, const NetworkAircraftConfig& config);
 		void changeModel(const std::string& callsign, const std::string& typeIcao, const std::string& airlineIcao);
 		void removePlane(const std::string& callsign);
 		void removeAllPlanes();
+
+	private:
+		void trackLatency(NetworkAircraft* plane, long long currentTimestamp);
+		static InterpolatedState fastPositionState(const NetworkAircraft* plane, long long currentTimestamp);
+		void followTerrain();
+
+		// without a fast update for this long an aircraft goes back to regular interpolation
+		static constexpr auto FastPositionTimeout = std::chrono::seconds(2);
+		// how long it takes to blend out the error between what was drawn and a new fast update
+		static constexpr long long FastPositionCorrectionTime = 1000000;
+
+		ClockOffsetEstimator m_clockOffset;
+		ModelResidency m_modelResidency;
+		std::vector<std::pair<double, NetworkAircraft*>> m_groundProbeCandidates;
+
+		// terrain probes per frame for taxiing aircraft (each is two XPLMProbeTerrainXYZ calls)
+		static constexpr size_t GroundProbeBudget = 24;
+		// aircraft that moved less than this (meters) since their last probe keep its elevation
+		static constexpr double MinGroundProbeDistance = 1.0;
 	};
 }
 
@@ -0,0 +1,117 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef AsyncLog_h
+#define AsyncLog_h
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "SpscQueue.h"
+
+namespace xpilot
+{
+	enum class LogCategory
+	{
+		General,
+		Network,       // socket, session capture, own-ship telemetry
+		Interpolation,
+		Terrain,
+		Csl,           // package loading and model matching
+		Ui,
+		Count
+	};
+
+	constexpr size_t LogCategoryCount = static_cast<size_t>(LogCategory::Count);
+
+	/**
+	 * Short name used in Log.txt and in the LogLevels section of Config.json.
+	 */
+	const char* LogCategoryName(LogCategory category);
+
+	struct LogRecord
+	{
+		long long time;  // steady clock, microseconds
+		int level;
+		LogCategory category;
+		char text[500];
+	};
+
+	/**
+	 * Backend of LOG_MSG. Any thread formats its message into a record in its own ring,
+	 * which costs no lock and no file I/O; the sim thread writes the records to Log.txt in
+	 * batches, one XPLMDebugString call per flush. When a thread logs faster than the rings
+	 * are flushed its newest records are dropped and counted. The ring of a thread that
+	 * exited goes to the next thread that logs once everything in it is written.
+	 */
+	class AsyncLog
+	{
+	public:
+		static AsyncLog& Instance();
+
+		void write(LogCategory category, int level, const char* msg, va_list args);
+
+		/**
+		 * The level filter of LOG_MSG and LOG_CAT: one relaxed atomic load, from any thread.
+		 */
+		bool isEnabled(LogCategory category, int level)const
+		{
+			return level >= m_levels[static_cast<size_t>(category)].load(std::memory_order_relaxed);
+		}
+		void setLevel(LogCategory category, int level);
+
+		/**
+		 * Sim thread only. Writes what's queued, for about as long as the budget allows.
+		 */
+		void flush(std::chrono::microseconds budget);
+
+		/**
+		 * Sim thread only. Writes everything queued, e.g. before the plugin is stopped.
+		 */
+		void flushAll();
+
+	private:
+		AsyncLog();
+
+		static constexpr size_t RingCapacity = 256;
+		struct ThreadRing
+		{
+			SpscQueue<LogRecord, RingCapacity> records;
+			std::atomic<uint32_t> dropped{ 0 };
+			std::atomic<bool> threadExited{ false }; // free for another thread once drained
+		};
+
+		ThreadRing* threadRing();
+		void flushUntil(std::chrono::steady_clock::time_point deadline);
+
+		std::array<std::atomic<int>, LogCategoryCount> m_levels;
+		std::mutex m_ringsMutex; // only taken when a thread logs for the first time, and by flush()
+		std::vector<std::unique_ptr<ThreadRing>> m_rings;
+		std::vector<LogRecord> m_batch;
+		std::string m_text;
+	};
+}
+
+#endif // !AsyncLog_h
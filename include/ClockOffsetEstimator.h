@@ -0,0 +1,67 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef ClockOffsetEstimator_h
+#define ClockOffsetEstimator_h
+
+#include <deque>
+
+namespace xpilot
+{
+	/**
+	 * Estimates the offset between a remote clock and ours from timestamped samples.
+	 *
+	 * Every sample's observed offset is the true offset plus that sample's transit delay,
+	 * which is never negative, so the smallest offset seen over the last Window is the best
+	 * estimate; it follows slow drift while ignoring samples that were held up on the way.
+	 * All times are microseconds.
+	 */
+	class ClockOffsetEstimator
+	{
+	public:
+		static constexpr long long Window = 30000000;
+
+		// an observation this far from the estimate means the remote clock was stepped, or
+		// a different source (e.g. a session replay) took over, so start over
+		static constexpr long long MaxDeviation = 60000000;
+
+		void addSample(long long localTime, long long remoteTime);
+		void reset() { m_window.clear(); }
+
+		bool hasEstimate()const { return !m_window.empty(); }
+
+		/**
+		 * local time - remote time; only valid if hasEstimate()
+		 */
+		long long offset()const { return m_window.front().offset; }
+
+		long long toLocal(long long remoteTime)const { return remoteTime + offset(); }
+
+	private:
+		struct Sample
+		{
+			long long localTime;
+			long long offset;
+		};
+
+		// ascending by offset, so the front is always the minimum within the window
+		std::deque<Sample> m_window;
+	};
+}
+
+#endif // !ClockOffsetEstimator_h
@@ -0,0 +1,63 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef Compression_h
+#define Compression_h
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace xpilot
+{
+	/**
+	 * Compressed socket frames use the LZ4 block format so that any stock LZ4
+	 * implementation on the client side can decode them.
+	 *
+	 * Frame layout: the 4-byte magic "XPZ4", the uncompressed size as a
+	 * little-endian uint32, then a single LZ4 block.
+	 */
+	constexpr char CompressedFrameMagic[4] = { 'X', 'P', 'Z', '4' };
+	constexpr size_t CompressedFrameHeaderSize = 8;
+	constexpr size_t DefaultCompressionThreshold = 1024;
+	constexpr size_t MinCompressionThreshold = 256;
+	constexpr size_t MaxDecompressedFrameSize = 64 * 1024 * 1024;
+
+	/**
+	 * Compresses src into dst as a raw LZ4 block. dst is overwritten.
+	 */
+	void Lz4CompressBlock(const uint8_t* src, size_t srcSize, std::string& dst);
+
+	/**
+	 * Decompresses a raw LZ4 block that is known to expand to exactly dstSize bytes.
+	 * Returns false for malformed input; never reads or writes out of bounds.
+	 */
+	bool Lz4DecompressBlock(const uint8_t* src, size_t srcSize, size_t dstSize, std::string& dst);
+
+	bool IsCompressedFrame(const void* data, size_t size);
+
+	/**
+	 * Wraps msg into a compressed frame. Returns false (and leaves frame untouched)
+	 * if compression would not make the message smaller.
+	 */
+	bool CompressFrame(const std::string& msg, std::string& frame);
+
+	bool DecompressFrame(const void* data, size_t size, std::string& msg);
+}
+
+#endif // !Compression_h
@@ -19,6 +19,7 @@
 #ifndef Config_h
 #define Config_h
 
+#include <map>
 #include <string>
 #include <vector>
 #include "Constants.h"
@@ -162,8 +163,42 @@ namespace xpilot
             return m_logLevel;
         }
 
+        // overrides LogLevel for one category of messages (see LogCategoryName), -1 removes it
+        bool setCategoryLogLevel(const std::string& category, int lvl);
+
+        bool setAdaptiveJitterBuffer(bool enabled);
+        bool getAdaptiveJitterBuffer()const
+        {
+            return m_adaptiveJitterBuffer;
+        }
+
+        bool setCubicInterpolation(bool enabled);
+        bool getCubicInterpolation()const
+        {
+            return m_cubicInterpolation;
+        }
+
+        bool setModelLoadDistance(int nm);
+        int getModelLoadDistance()const
+        {
+            return m_modelLoadDistance;
+        }
+
+        bool setMaxLoadedModels(int count);
+        int getMaxLoadedModels()const
+        {
+            return m_maxLoadedModels;
+        }
+
+        bool setConsoleHistoryLimit(int messages);
+        int getConsoleHistoryLimit()const
+        {
+            return m_consoleHistoryLimit;
+        }
+
     private:
         Config() = default;
+        void applyLogLevels()const;
         std::vector<CslPackage> m_cslPackages;
         std::string m_defaultAcIcaoType = "A320";
         bool m_showHideLabels = true;
@@ -178,6 +213,12 @@ namespace xpilot
         int m_maxLabelDist = 3;
         bool m_labelCutoffVis = true;
         int m_logLevel = 2; // 0=Debug, 1=Info, 2=Warning, 3=Error, 4=Fatal, 5=Msg
+        std::map<std::string, int> m_categoryLogLevels;
+        bool m_adaptiveJitterBuffer = false;
+        bool m_cubicInterpolation = false;
+        int m_modelLoadDistance = 0; // nm, 0 = every aircraft gets its model right away
+        int m_maxLoadedModels = 100;
+        int m_consoleHistoryLimit = 1000; // messages kept per text console tab
     };
 }
 
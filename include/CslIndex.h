@@ -0,0 +1,95 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef CslIndex_h
+#define CslIndex_h
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace xpilot
+{
+	struct CslModelEntry
+	{
+		std::string name;           // OBJ8_AIRCRAFT
+		std::string icao;
+		std::string airline;
+		std::string livery;
+		std::string classification; // Doc8643 description, e.g. L2J
+		std::string objPath;
+	};
+
+	struct CslFolderEntry
+	{
+		std::string path;           // folder holding the xsb_aircraft.txt
+		std::string exportName;     // EXPORT_NAME, the package part of XPMP2's model ids
+		std::vector<CslModelEntry> models; // one per match line of a model
+		uint32_t modelCount = 0;    // distinct OBJ8_AIRCRAFT models
+	};
+
+	/**
+	 * Modification time and size of a file or folder the index of a package depends on:
+	 * every folder walked to find the xsb_aircraft.txt files, and the files themselves.
+	 */
+	struct CslFingerprint
+	{
+		std::string path;
+		int64_t mtime;
+		int64_t size;
+	};
+
+	struct CslPackageIndex
+	{
+		std::string root;
+		std::vector<CslFingerprint> fingerprints;
+		std::vector<CslFolderEntry> folders;
+
+		size_t modelCount()const;
+	};
+
+	typedef std::unordered_map<std::string, std::string> Doc8643Classes; // ICAO type -> description
+
+	/**
+	 * What we know about the installed CSL packages, persisted between sessions so an
+	 * unchanged package doesn't have to be walked again: checking its fingerprints costs
+	 * one stat per folder instead of listing every model's files.
+	 *
+	 * Plain functions and data; scan() and isCurrent() are safe to call from worker threads.
+	 */
+	class CslIndex
+	{
+	public:
+		bool load(const std::string& path);
+		bool save(const std::string& path)const;
+
+		const CslPackageIndex* find(const std::string& root)const;
+		void put(const CslPackageIndex& package);
+
+		static CslPackageIndex scan(const std::string& root, const Doc8643Classes& classes, const std::atomic<bool>* stopRequested = nullptr);
+		static bool isCurrent(const CslPackageIndex& package);
+		static Doc8643Classes loadDoc8643(const std::string& path);
+
+	private:
+		std::vector<CslPackageIndex> m_packages;
+	};
+}
+
+#endif // !CslIndex_h
@@ -0,0 +1,107 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef CslLoader_h
+#define CslLoader_h
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CslIndex.h"
+
+namespace xpilot
+{
+	/**
+	 * Loads CSL packages without freezing the sim.
+	 *
+	 * Worker threads walk the package folders in parallel, find every xsb_aircraft.txt and read
+	 * it (so XPMP2 later finds it in the OS cache). Packages that haven't changed since the
+	 * last session are taken from the persistent CslIndex instead of being walked again. Registering a folder with XPMP2 has to
+	 * happen on the sim thread; commit() does that for as long as its time budget allows each
+	 * frame, in configuration order so the same package wins for duplicate models as before.
+	 */
+	class CslLoader
+	{
+	public:
+		~CslLoader();
+
+		/**
+		 * Starts scanning the packages; indexPath is where the CslIndex is read from and,
+		 * once a package had to be rescanned, written back to.
+		 */
+		void start(const std::vector<std::string>& packages, const std::string& indexPath, const std::string& doc8643Path);
+		void stop();
+
+		bool hasStarted()const { return m_started; }
+
+		/**
+		 * Registers scanned folders with XPMP2 until the budget is used up; sim thread only.
+		 * Returns true once every package is loaded.
+		 */
+		bool commit(std::chrono::microseconds budget);
+
+		size_t packageCount()const { return m_scans.size(); }
+		size_t foldersLoaded()const { return m_foldersLoaded; }
+		size_t modelsLoaded()const { return m_modelsLoaded; }
+
+	private:
+		struct PackageScan
+		{
+			std::string root;
+			CslPackageIndex index;
+			bool fromIndex = false;
+			long long scanMicros = 0;
+			long long finishedAt = 0;           // microseconds since start()
+			std::atomic<bool> done{ false };
+		};
+
+		void scanWorker();
+		void scanPackage(PackageScan& scan);
+		const Doc8643Classes& doc8643Classes();
+		void saveIndex();
+
+		bool m_started = false;
+		bool m_finished = false;
+		std::vector<std::unique_ptr<PackageScan>> m_scans;
+		std::vector<std::thread> m_workers;
+		std::atomic<size_t> m_nextScan{ 0 };
+		std::atomic<bool> m_stopRequested{ false };
+
+		CslIndex m_index;
+		std::string m_indexPath;
+		std::string m_doc8643Path;
+		Doc8643Classes m_doc8643;
+		bool m_doc8643Loaded = false;
+		std::mutex m_doc8643Mutex;
+
+		size_t m_commitPackage = 0;
+		size_t m_commitFolder = 0;
+		size_t m_foldersLoaded = 0;
+		size_t m_modelsLoaded = 0;
+		size_t m_commitFrames = 0;
+		long long m_commitMicros = 0;
+		std::chrono::steady_clock::time_point m_startTime;
+	};
+}
+
+#endif // !CslLoader_h
@@ -0,0 +1,57 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef DiagnosticsWindow_h
+#define DiagnosticsWindow_h
+
+#include <array>
+#include <vector>
+#include <chrono>
+
+#include "XPImgWindow.h"
+#include "Profiler.h"
+
+namespace xpilot
+{
+	class DiagnosticsWindow : public XPImgWindow
+	{
+	public:
+		DiagnosticsWindow(WndMode _mode = WND_MODE_FLOAT_CENTERED);
+		~DiagnosticsWindow() final = default;
+	protected:
+		void buildInterface() override;
+	private:
+		struct StageStats
+		{
+			long long p50 = 0;
+			long long p99 = 0;
+			long long max = 0;
+		};
+
+		void updateStats();
+		void buildLatencyInterface();
+
+		std::vector<ProfilerFrame> m_frames;
+		std::vector<long long> m_scratch;
+		std::array<StageStats, ProfilerStageCount + 1> m_stats; // the last entry is the frame total
+		size_t m_sampleCount = 0;
+		std::chrono::steady_clock::time_point m_nextUpdate;
+	};
+}
+
+#endif // !DiagnosticsWindow_h
@@ -29,6 +29,9 @@ struct InterpolatedState
     double bank;
     double heading;
     double groundSpeed;
+    long long receivedAt; // steady clock microseconds, see LatencyTracker
+    long long dequeuedAt;
+    bool rendered;
 };
 
 #endif // !InterpolatedState_h
@@ -0,0 +1,97 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef Interpolation_h
+#define Interpolation_h
+
+#include <deque>
+
+#include "InterpolatedState.h"
+
+/**
+ * The position interpolation kernel. Nothing in here may depend on the X-Plane SDK
+ * or XPMP2, so it can be compiled and exercised outside of the simulator.
+ */
+namespace xpilot
+{
+	inline double NormalizeHeading(double heading)
+	{
+		if (heading <= 0.0) {
+			heading += 360.0;
+		}
+		else if (heading > 360.0) {
+			heading -= 360.0;
+		}
+		return heading;
+	}
+
+	enum class InterpolationMode
+	{
+		Linear,
+		Cubic // Catmull-Rom through the neighbouring snapshots; smooths the kinks of turning traffic
+	};
+
+	/**
+	 * How far past the newest snapshot an aircraft is dead-reckoned before it is held in place.
+	 */
+	constexpr long long MaxExtrapolationTime = 3000000;
+
+	/**
+	 * Returns the state at the given timestamp (microseconds), interpolated between the
+	 * two surrounding snapshots of the stack, or extrapolated from the last two if the
+	 * timestamp is past the newest one. The stack must not be empty.
+	 */
+	InterpolatedState InterpolateState(const std::deque<InterpolatedState>& stack, long long timestamp,
+		InterpolationMode mode = InterpolationMode::Linear);
+
+	/**
+	 * A position sample that comes with its own velocities (FastPositionUpdate).
+	 */
+	struct VelocityState
+	{
+		InterpolatedState sample;
+		double velocityNorth; // meters per second
+		double velocityEast;
+		double velocityUp;
+		double pitchRate;     // degrees per second
+		double bankRate;
+		double headingRate;
+	};
+
+	/**
+	 * Advances the sample by its velocities to the given timestamp, for at most MaxExtrapolationTime.
+	 */
+	InterpolatedState ProjectVelocityState(const VelocityState& state, long long timestamp);
+
+	/**
+	 * How far the drawn state is from the target, channel by channel (heading and longitude wrapped).
+	 */
+	InterpolatedState StateError(const InterpolatedState& drawn, const InterpolatedState& target);
+
+	/**
+	 * Adds the given fraction of a StateError to the state.
+	 */
+	InterpolatedState ApplyStateError(const InterpolatedState& state, const InterpolatedState& error, double fraction);
+
+	/**
+	 * Drops snapshots that can no longer be part of an interpolation segment or its tangents.
+	 */
+	void PruneInterpolationStack(std::deque<InterpolatedState>& stack, long long timestamp);
+}
+
+#endif // !Interpolation_h
@@ -0,0 +1,144 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef LatencyTracker_h
+#define LatencyTracker_h
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace xpilot
+{
+	inline long long SteadyMicros()
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	/**
+	 * The hops a position update takes from the socket to the screen.
+	 */
+	enum class LatencyHop
+	{
+		Decode,   // received on the socket thread -> queued for the sim thread
+		Queue,    // queued -> dequeued by the flight loop
+		Buffer,   // dequeued -> first frame the state is interpolated towards
+		EndToEnd, // received -> first frame the state is interpolated towards
+		Count
+	};
+
+	constexpr size_t LatencyHopCount = static_cast<size_t>(LatencyHop::Count);
+
+	const char* LatencyHopName(LatencyHop hop);
+
+	/**
+	 * Log-linear histogram of microsecond values (4 buckets per power of two, up to about a minute).
+	 * Adding a value is a single relaxed atomic increment, so it can be fed from any thread.
+	 */
+	class LatencyHistogram
+	{
+	public:
+		static constexpr size_t BucketCount = 100;
+		typedef std::array<uint32_t, BucketCount> Buckets;
+
+		void add(long long micros);
+		void drain(Buckets& out); // copies and resets the buckets
+
+		static long long percentile(const Buckets& buckets, double p);
+		static uint64_t count(const Buckets& buckets);
+
+	private:
+		static size_t bucketIndex(long long micros);
+		static long long bucketUpperBound(size_t idx);
+
+		std::array<std::atomic<uint32_t>, BucketCount> m_buckets{};
+	};
+
+	struct LatencyStats
+	{
+		long long p50 = 0;
+		long long p99 = 0;
+		uint64_t count = 0;
+	};
+
+	/**
+	 * Tracks per-hop latency of position updates and, if enabled, sizes the interpolation
+	 * (jitter) buffer to the smallest delay that keeps interpolation underruns below
+	 * TargetUnderrunRate.
+	 *
+	 * record() and recordArrivalGap() may be called from any thread; everything else is
+	 * sim thread only.
+	 */
+	class LatencyTracker
+	{
+	public:
+		static LatencyTracker& Instance();
+
+		static constexpr long long FixedBufferDelay = 5500000;
+		static constexpr long long MinBufferDelay = 500000;
+		static constexpr double TargetUnderrunRate = 0.01;
+
+		void record(LatencyHop hop, long long micros) { m_hops[static_cast<size_t>(hop)].add(micros); }
+		void recordArrivalGap(long long micros) { m_gaps.add(micros); }
+
+		void recordUpdate() { m_updates++; }
+		void recordUnderrun() { m_underruns++; }
+
+		void setAdaptive(bool adaptive);
+		bool isAdaptive()const { return m_adaptive; }
+
+		/**
+		 * The delay, in microseconds, to apply to newly received states.
+		 */
+		long long bufferDelay()const { return m_bufferDelay; }
+
+		/**
+		 * Publishes new statistics and adjusts the buffer delay every 10 seconds; call once per frame.
+		 */
+		void update();
+
+		/**
+		 * Publishes the statistics gathered since the last update right away.
+		 */
+		void publish();
+
+		const LatencyStats& hopStats(LatencyHop hop)const { return m_hopStats[static_cast<size_t>(hop)]; }
+		float underrunRate()const { return m_underrunRate; }
+
+	private:
+		LatencyTracker() = default;
+		void adjustBufferDelay();
+
+		std::array<LatencyHistogram, LatencyHopCount> m_hops;
+		std::array<LatencyStats, LatencyHopCount> m_hopStats;
+		LatencyHistogram m_gaps;
+		LatencyHistogram::Buckets m_gapHistory{};
+
+		std::atomic<uint32_t> m_updates{ 0 };
+		std::atomic<uint32_t> m_underruns{ 0 };
+		float m_underrunRate = 0.0f;
+
+		bool m_adaptive = false;
+		long long m_bufferDelay = FixedBufferDelay;
+		long long m_margin = 250000;
+		std::chrono::steady_clock::time_point m_nextPublish;
+	};
+}
+
+#endif // !LatencyTracker_h
@@ -0,0 +1,61 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef ModelMatchCache_h
+#define ModelMatchCache_h
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "CslIndex.h"
+
+namespace xpilot
+{
+	/**
+	 * Remembers which CSL model XPMP2 picked for an ICAO type, airline and livery, so the
+	 * next aircraft with the same combination is assigned that model directly instead of
+	 * searching every installed model again. Sim thread only.
+	 */
+	class ModelMatchCache
+	{
+	public:
+		static ModelMatchCache& Instance();
+
+		bool find(const std::string& typeIcao, const std::string& airlineIcao, const std::string& livery, std::string& modelId)const;
+		void store(const std::string& typeIcao, const std::string& airlineIcao, const std::string& livery, const std::string& modelId);
+		void clear();
+
+		/**
+		 * Seeds the cache with the exact combinations the packages provide, in load order so
+		 * the first package wins like it does in XPMP2.
+		 */
+		void prewarm(const std::vector<const CslPackageIndex*>& packages);
+
+		size_t size()const { return m_models.size(); }
+
+	private:
+		ModelMatchCache() = default;
+
+		static std::string key(const std::string& typeIcao, const std::string& airlineIcao, const std::string& livery);
+
+		std::unordered_map<std::string, std::string> m_models;
+	};
+}
+
+#endif // !ModelMatchCache_h
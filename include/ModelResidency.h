@@ -0,0 +1,69 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef ModelResidency_h
+#define ModelResidency_h
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace xpilot
+{
+	class NetworkAircraft;
+
+	/**
+	 * Decides which aircraft get their real CSL model. XPMP2 loads a model's objects when the
+	 * first aircraft is assigned to it and unloads them some time after the last one let go,
+	 * so the memory held is driven by the number of distinct models in use.
+	 *
+	 * With a load distance configured, aircraft start out with a placeholder (the model XPMP2
+	 * picks for their type alone, shared by every airline) and only get their livery once they
+	 * come within that distance. Liveries no aircraft within range uses are kept, least
+	 * recently needed first, until more than the configured number are loaded; then their
+	 * aircraft go back to the placeholder. Sim thread only.
+	 */
+	class ModelResidency
+	{
+	public:
+		void update();
+
+		static void loadModel(NetworkAircraft* plane, const std::string& typeIcao, const std::string& airlineIcao, const std::string& livery);
+		static void showPlaceholder(NetworkAircraft* plane);
+
+	private:
+		struct ModelUse
+		{
+			long long lastNeeded = 0;
+			size_t planes = 0;
+		};
+
+		static void promote(NetworkAircraft* plane);
+
+		// aircraft keep their livery until this much further out than the load distance
+		static constexpr double UnloadHysteresis = 1.25;
+		// model matches and assignments per frame
+		static constexpr size_t MaxLoadsPerFrame = 2;
+
+		std::unordered_map<std::string, ModelUse> m_models; // by cslId (package/short id)
+		std::vector<std::pair<float, NetworkAircraft*>> m_pending;
+		long long m_frame = 0;
+	};
+}
+
+#endif // !ModelResidency_h
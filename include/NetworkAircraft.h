@@ -23,6 +23,7 @@
 
 #include "XPilotAPI.h"
 #include "InterpolatedState.h"
+#include "Interpolation.h"
 #include "TerrainProbe.h"
 
 #include "XPCAircraft.h"
@@ -58,6 +59,20 @@ namespace xpilot
         float targetReversersPosition;
         bool spoilersDeployed;
         int renderCount;
+        bool interpolationUnderrun;
+        long long lastReceivedAt;
+        long long lastSourceTimestamp;
+        bool fastPositionActive;
+        VelocityState fastPosition;
+        InterpolatedState fastPositionError;
+        long long fastPositionErrorAt;
+        std::chrono::steady_clock::time_point lastFastPositionUpdate;
+        bool hasGroundProbe;
+        double groundProbeLatitude;
+        double groundProbeLongitude;
+        double groundProbeElevation;
+        bool modelDeferred;         // showing the placeholder until within the model load distance
+        std::string requestedModel; // explicit model from AddPlane, assigned instead of matching
         std::string origin;
         std::string destination;
         std::chrono::system_clock::time_point previousSurfaceUpdateTime;
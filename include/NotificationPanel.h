@@ -19,8 +19,9 @@
 #ifndef NotificationPanel_h
 #define NotificationPanel_h
 
-#include <list>
+#include <array>
 #include <chrono>
+#include <string>
 
 #include "ImgWindow.h"
 #include "XplaneCommand.h"
@@ -39,6 +40,20 @@ namespace xpilot
     protected:
         void buildInterface()override;
     private:
+        struct NotificationTy
+        {
+            std::string message;
+            ImVec4 color;            // converted once when the message is added
+            float wrapWidth = -1.0f;
+            float height = 0.0f;     // of the wrapped text at wrapWidth
+        };
+
+        // the panel is 100 px tall; the console keeps the full history
+        static constexpr size_t MaxNotifications = 16;
+        std::array<NotificationTy, MaxNotifications> m_notifications;
+        size_t m_newest = 0;
+        size_t m_notificationCount = 0;
+
         static float onFlightLoop(float, float, int, void* refcon);
         XPLMFlightLoopID m_flightLoopId;
         std::chrono::system_clock::time_point m_disappearTime;
@@ -0,0 +1,145 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef OwnshipTelemetry_h
+#define OwnshipTelemetry_h
+
+#include <string>
+#include <atomic>
+#include <cstdint>
+
+#include "DataRefAccess.h"
+#include "SpscQueue.h"
+#include "XPLMProcessing.h"
+
+namespace xpilot
+{
+	class ZmqReactor;
+
+	/**
+	 * Binary own-ship frame sent to the pilot client.
+	 *
+	 * Wire format (little-endian, no padding): the 4-byte magic "XPOS",
+	 * a uint16 frame version, a uint16 payload size, then the sample itself.
+	 * JSON messages never start with 'X', so the client can tell frames apart by the first byte.
+	 */
+#pragma pack(push, 1)
+	struct OwnshipTelemetrySample
+	{
+		uint32_t sequence;
+		int64_t timestamp;          // microseconds since epoch, same clock as InterpolatedState
+		double latitude;
+		double longitude;
+		double altitudeMsl;         // meters
+		float altitudeAgl;          // meters
+		float pitch;                // degrees
+		float bank;                 // degrees
+		float heading;              // degrees true
+		float groundSpeed;          // meters/second
+		float indicatedAirspeed;    // knots
+		float verticalSpeed;        // feet/minute
+		float velocityX;            // OpenGL local frame, meters/second
+		float velocityY;
+		float velocityZ;
+		float rollRate;             // P, degrees/second
+		float pitchRate;            // Q, degrees/second
+		float yawRate;              // R, degrees/second
+		float flapRatio;
+		float speedbrakeRatio;
+		uint8_t gearDown;
+		uint8_t onGround;
+		int32_t com1Frequency;      // Hz / 1000 (8.33 kHz spacing)
+		int32_t com2Frequency;
+		int32_t transponderCode;
+		int32_t transponderMode;
+	};
+#pragma pack(pop)
+
+	constexpr char TelemetryFrameMagic[4] = { 'X', 'P', 'O', 'S' };
+	constexpr uint16_t TelemetryFrameVersion = 1;
+
+	/**
+	 * Samples own-ship state on the sim thread at a fixed rate and hands it to the
+	 * socket thread through a lock-free queue. The client opts in with a
+	 * "RequestTelemetry" message; a rate of 0 stops the stream.
+	 */
+	class OwnshipTelemetry
+	{
+	public:
+		OwnshipTelemetry(ZmqReactor* reactor);
+		~OwnshipTelemetry();
+
+		OwnshipTelemetry(const OwnshipTelemetry&) = delete;
+		OwnshipTelemetry& operator=(const OwnshipTelemetry&) = delete;
+
+		/**
+		 * Sets the sample rate in Hz (clamped to MaxRateHz), 0 disables the stream.
+		 * Must be called on the sim thread.
+		 */
+		void setRate(float hz);
+		float getRate()const { return m_rateHz; }
+
+		/**
+		 * Pops the next encoded frame. Called on the socket thread only.
+		 */
+		bool popFrame(std::string& frame);
+
+		uint64_t droppedSamples()const { return m_dropped; }
+
+		static constexpr float MaxRateHz = 30.0f;
+
+	protected:
+		DataRefAccess<double> m_latitude;
+		DataRefAccess<double> m_longitude;
+		DataRefAccess<double> m_elevation;
+		DataRefAccess<float> m_agl;
+		DataRefAccess<float> m_pitch;
+		DataRefAccess<float> m_bank;
+		DataRefAccess<float> m_heading;
+		DataRefAccess<float> m_groundSpeed;
+		DataRefAccess<float> m_indicatedAirspeed;
+		DataRefAccess<float> m_verticalSpeed;
+		DataRefAccess<float> m_velocityX;
+		DataRefAccess<float> m_velocityY;
+		DataRefAccess<float> m_velocityZ;
+		DataRefAccess<float> m_rollRate;
+		DataRefAccess<float> m_pitchRate;
+		DataRefAccess<float> m_yawRate;
+		DataRefAccess<float> m_flapRatio;
+		DataRefAccess<float> m_speedbrakeRatio;
+		DataRefAccess<int> m_gearDown;
+		DataRefAccess<int> m_onGround;
+		DataRefAccess<int> m_com1Frequency;
+		DataRefAccess<int> m_com2Frequency;
+		DataRefAccess<int> m_transponderCode;
+		DataRefAccess<int> m_transponderMode;
+
+	private:
+		static float flightLoopCallback(float, float, int, void* ref);
+		void sample();
+
+		ZmqReactor* m_reactor;
+		XPLMFlightLoopID m_flightLoopId;
+		float m_rateHz;
+		uint32_t m_sequence;
+		std::atomic<uint64_t> m_dropped{ 0 };
+		SpscQueue<OwnshipTelemetrySample, 64> m_queue;
+	};
+}
+
+#endif // !OwnshipTelemetry_h
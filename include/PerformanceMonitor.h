@@ -0,0 +1,77 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef PerformanceMonitor_h
+#define PerformanceMonitor_h
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "OwnedDataRef.h"
+
+namespace xpilot
+{
+	class ZmqReactor;
+
+	/**
+	 * Publishes the plugin's own load as datarefs under xpilot/perf/ so it can be charted
+	 * next to the sim frame rate by external recorders.
+	 *
+	 * Per-frame values are written every frame; rates and aircraft counts are refreshed
+	 * once per second to keep the per-frame cost to a handful of stores.
+	 */
+	class PerformanceMonitor
+	{
+	public:
+		PerformanceMonitor(const ZmqReactor* reactor);
+
+		void onFrame(size_t queueDepth, long long drainMicros, long long interpolationMicros);
+
+	private:
+		void updateRates(double seconds);
+		void updateAircraftBands();
+		void updateLatency();
+
+		const ZmqReactor* m_reactor;
+
+		OwnedDataRef<float> m_messagesInPerSecond;
+		OwnedDataRef<float> m_bytesInPerSecond;
+		OwnedDataRef<float> m_messagesOutPerSecond;
+		OwnedDataRef<int> m_queueDepth;
+		OwnedDataRef<float> m_drainTime;
+		OwnedDataRef<float> m_interpolationTime;
+		OwnedDataRef<int> m_terrainProbesPerFrame;
+		OwnedDataRef<int> m_aircraftNear;
+		OwnedDataRef<int> m_aircraftMedium;
+		OwnedDataRef<int> m_aircraftFar;
+		OwnedDataRef<int> m_aircraftDistant;
+		OwnedDataRef<std::vector<float>> m_latencyP50; // indexed by LatencyHop
+		OwnedDataRef<std::vector<float>> m_latencyP99;
+		OwnedDataRef<float> m_interpolationDelay;
+		OwnedDataRef<float> m_underrunRate;
+
+		std::chrono::steady_clock::time_point m_lastRateUpdate;
+		uint64_t m_lastMessagesIn = 0;
+		uint64_t m_lastBytesIn = 0;
+		uint64_t m_lastMessagesOut = 0;
+		uint64_t m_lastTerrainProbes = 0;
+	};
+}
+
+#endif // !PerformanceMonitor_h
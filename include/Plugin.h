@@ -49,6 +49,25 @@ inline int ToggleTcasCommandHandler(XPLMCommandRef inCommand, XPLMCommandPhase i
 inline XPLMCommandRef ToggleAircraftLabelsCommand = NULL;
 inline int ToggleAircraftLabelsCommandHandler(XPLMCommandRef inCommand, XPLMCommandPhase inPhase, void* inRefcon);
 
+inline XPLMCommandRef ToggleDiagnosticsWindowCommand = NULL;
+inline int ToggleDiagnosticsWindowCommandHandler(XPLMCommandRef inCommand, XPLMCommandPhase inPhase, void* inRefcon);
+
+inline XPLMCommandRef ToggleTracingCommand = NULL;
+inline int ToggleTracingCommandHandler(XPLMCommandRef inCommand, XPLMCommandPhase inPhase, void* inRefcon);
+
+inline XPLMCommandRef SaveTraceCommand = NULL;
+inline int SaveTraceCommandHandler(XPLMCommandRef inCommand, XPLMCommandPhase inPhase, void* inRefcon);
+
+inline XPLMCommandRef ToggleSessionRecordingCommand = NULL;
+inline int ToggleSessionRecordingCommandHandler(XPLMCommandRef inCommand, XPLMCommandPhase inPhase, void* inRefcon);
+
+inline XPLMCommandRef ReplaySessionCommand = NULL;
+inline XPLMCommandRef ReplaySessionFastCommand = NULL;
+inline int ReplaySessionCommandHandler(XPLMCommandRef inCommand, XPLMCommandPhase inPhase, void* inRefcon);
+
+inline XPLMCommandRef ToggleTrafficBenchmarkCommand = NULL;
+inline int ToggleTrafficBenchmarkCommandHandler(XPLMCommandRef inCommand, XPLMCommandPhase inPhase, void* inRefcon);
+
 inline XPLMCommandRef ContactAtcCommand = XPLMFindCommand("sim/operation/contact_atc");
 inline int ContactAtcCommandHandler(XPLMCommandRef inCommand, XPLMCommandPhase inPhase, void* inRefcon);
 
@@ -61,5 +80,10 @@ static int MenuTextMessageConsole = 0;
 static int MenuNotificationPanel = 0;
 static int MenuToggleTcas = 0;
 static int MenuToggleAircraftLabels = 0;
+static int MenuDiagnostics = 0;
+static int MenuToggleTracing = 0;
+static int MenuSaveTrace = 0;
+static int MenuToggleSessionRecording = 0;
+static int MenuReplaySession = 0;
 
 #endif // !Plugin_h
@@ -0,0 +1,64 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef PluginHash_h
+#define PluginHash_h
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace xpilot
+{
+	/**
+	 * SHA-512 of the plugin binary, which the client asks for to verify the installation.
+	 * Reading and hashing the binary takes long enough to be noticeable during plugin
+	 * start, so it's done on a thread of its own and requests are answered once it's done.
+	 */
+	class PluginHash
+	{
+	public:
+		typedef std::function<void(const std::string& hash)> Callback;
+
+		~PluginHash();
+
+		void start(const std::string& path);
+		bool hasStarted()const { return m_thread.joinable(); }
+		bool isReady();
+
+		/**
+		 * Calls back right away if the hash is known, otherwise from the hashing thread.
+		 */
+		void get(const Callback& callback);
+
+	private:
+		void compute(const std::string& path);
+
+		std::thread m_thread;
+		std::atomic<bool> m_stopRequested{ false };
+		std::mutex m_mutex;
+		bool m_ready = false;
+		std::string m_hash;
+		std::vector<Callback> m_waiting;
+	};
+}
+
+#endif // !PluginHash_h
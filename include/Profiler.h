@@ -0,0 +1,150 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef Profiler_h
+#define Profiler_h
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <cstdint>
+
+#include "Tracer.h"
+
+namespace xpilot
+{
+	enum class ProfilerStage
+	{
+		QueuedCallbacks,
+		Interpolation,
+		MenuUpdate,
+		UpdatePosition,
+		NotificationPanel,
+		NotificationPanelWindow,
+		TextMessageConsoleWindow,
+		NearbyAtcWindow,
+		SettingsWindow,
+		DiagnosticsWindow,
+		Count
+	};
+
+	constexpr size_t ProfilerStageCount = static_cast<size_t>(ProfilerStage::Count);
+
+	const char* ProfilerStageName(ProfilerStage stage);
+
+	/**
+	 * Time spent in each stage during one X-Plane frame, in microseconds. Stages that
+	 * run several times per frame (e.g. UpdatePosition, once per aircraft) are summed.
+	 */
+	struct ProfilerFrame
+	{
+		uint64_t frame = 0;
+		std::array<long long, ProfilerStageCount> micros{};
+
+		long long total()const
+		{
+			long long sum = 0;
+			for (long long m : micros) sum += m;
+			return sum;
+		}
+	};
+
+	/**
+	 * Collects per-stage frame times on the sim thread. All stages that are profiled run on
+	 * the sim thread, so accumulating needs no synchronization; finished frames go into a
+	 * fixed ring that is never resized and never locked.
+	 */
+	class Profiler
+	{
+	public:
+		static Profiler& Instance();
+		static constexpr size_t HistorySize = 1024;
+
+		void setEnabled(bool enabled);
+		bool isEnabled()const { return m_enabled.load(std::memory_order_relaxed); }
+
+		void add(ProfilerStage stage, long long micros)
+		{
+			m_current.micros[static_cast<size_t>(stage)] += micros;
+		}
+
+		/**
+		 * Publishes the stages accumulated since the previous call as one frame.
+		 */
+		void endFrame();
+
+		bool lastFrame(ProfilerFrame& frame)const;
+
+		/**
+		 * Copies up to maxFrames of the most recent frames, oldest first.
+		 */
+		void snapshot(std::vector<ProfilerFrame>& frames, size_t maxFrames)const;
+
+	private:
+		Profiler() = default;
+
+		std::atomic<bool> m_enabled{ false };
+		ProfilerFrame m_current;
+		std::array<ProfilerFrame, HistorySize> m_history;
+		std::atomic<uint64_t> m_frameCount{ 0 };
+	};
+
+	/**
+	 * Adds the lifetime of the scope to the given stage if profiling is enabled, and
+	 * records it as a trace event if tracing is enabled.
+	 */
+	class ProfileScope
+	{
+	public:
+		explicit ProfileScope(ProfilerStage stage) :
+			m_stage(stage),
+			m_profiling(Profiler::Instance().isEnabled()),
+			m_tracing(Tracer::Instance().isEnabled())
+		{
+			if (m_profiling || m_tracing) m_start = std::chrono::steady_clock::now();
+		}
+
+		~ProfileScope()
+		{
+			if (m_profiling || m_tracing)
+			{
+				const auto end = std::chrono::steady_clock::now();
+				if (m_profiling)
+				{
+					Profiler::Instance().add(m_stage, std::chrono::duration_cast<std::chrono::microseconds>(end - m_start).count());
+				}
+				if (m_tracing)
+				{
+					Tracer::Instance().record(ProfilerStageName(m_stage), m_start, end);
+				}
+			}
+		}
+
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+
+	private:
+		ProfilerStage m_stage;
+		bool m_profiling;
+		bool m_tracing;
+		std::chrono::steady_clock::time_point m_start;
+	};
+}
+
+#endif // !Profiler_h
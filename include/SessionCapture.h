@@ -0,0 +1,105 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef SessionCapture_h
+#define SessionCapture_h
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <chrono>
+#include <functional>
+#include <condition_variable>
+
+namespace xpilot
+{
+	/**
+	 * Capture file layout: the 4-byte magic "XPCP" and a little-endian uint32 version,
+	 * followed by one record per inbound message:
+	 *   varint  microseconds since the previous record (steady clock)
+	 *   varint  payload length
+	 *   bytes   payload (the message as handed to XPilot::processMessage)
+	 */
+	constexpr char CaptureFileMagic[4] = { 'X', 'P', 'C', 'P' };
+	constexpr uint32_t CaptureFileVersion = 1;
+
+	struct CapturedMessage
+	{
+		uint64_t offsetMicros; // time since the first record
+		std::string payload;
+	};
+
+	bool ReadCaptureFile(const std::string& path, std::vector<CapturedMessage>& messages);
+
+	/**
+	 * Appends inbound socket messages to a capture file.
+	 * record() is called on the socket thread, start()/stop() on the sim thread.
+	 */
+	class SessionRecorder
+	{
+	public:
+		~SessionRecorder();
+
+		bool start(const std::string& path);
+		void stop();
+		bool isRecording()const { return m_recording; }
+		void record(const std::string& msg);
+
+	private:
+		std::mutex m_mutex;
+		std::ofstream m_file;
+		std::string m_path;
+		std::atomic<bool> m_recording{ false };
+		std::chrono::steady_clock::time_point m_lastRecord;
+		uint64_t m_count = 0;
+		uint64_t m_bytes = 0;
+	};
+
+	/**
+	 * Feeds a capture file into a message handler on its own thread, either with the
+	 * original timing scaled by speed, or as fast as possible if speed is 0.
+	 */
+	class SessionPlayer
+	{
+	public:
+		typedef std::function<void(const std::string&)> MessageHandler;
+
+		SessionPlayer(MessageHandler handler);
+		~SessionPlayer();
+
+		bool start(const std::string& path, double speed = 1.0);
+		void stop();
+		bool isPlaying()const { return m_playing; }
+
+	private:
+		void run(std::vector<CapturedMessage> messages, double speed);
+
+		MessageHandler m_handler;
+		std::unique_ptr<std::thread> m_thread;
+		std::atomic<bool> m_playing{ false };
+		std::atomic<bool> m_stopRequested{ false };
+		std::mutex m_mutex;
+		std::condition_variable m_cv;
+	};
+}
+
+#endif // !SessionCapture_h
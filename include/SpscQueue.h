@@ -0,0 +1,79 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef SpscQueue_h
+#define SpscQueue_h
+
+#include <atomic>
+#include <array>
+#include <cstddef>
+
+namespace xpilot
+{
+	/**
+	 * Bounded, wait-free single-producer/single-consumer ring buffer.
+	 * Exactly one thread may call push() and exactly one (other) thread may call pop().
+	 * Capacity must be a power of two; one slot is never used to tell full from empty.
+	 */
+	template <typename T, size_t Capacity>
+	class SpscQueue
+	{
+		static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+	public:
+		bool push(const T& item)
+		{
+			const size_t head = m_head.load(std::memory_order_relaxed);
+			const size_t next = (head + 1) & (Capacity - 1);
+			if (next == m_tail.load(std::memory_order_acquire))
+				return false; // full
+			m_items[head] = item;
+			m_head.store(next, std::memory_order_release);
+			return true;
+		}
+
+		bool pop(T& item)
+		{
+			const size_t tail = m_tail.load(std::memory_order_relaxed);
+			if (tail == m_head.load(std::memory_order_acquire))
+				return false; // empty
+			item = m_items[tail];
+			m_tail.store((tail + 1) & (Capacity - 1), std::memory_order_release);
+			return true;
+		}
+
+		bool empty()const
+		{
+			return m_tail.load(std::memory_order_acquire) == m_head.load(std::memory_order_acquire);
+		}
+
+		size_t size()const
+		{
+			const size_t head = m_head.load(std::memory_order_acquire);
+			const size_t tail = m_tail.load(std::memory_order_acquire);
+			return (head - tail) & (Capacity - 1);
+		}
+
+	private:
+		std::array<T, Capacity> m_items{};
+		alignas(64) std::atomic<size_t> m_head{ 0 };
+		alignas(64) std::atomic<size_t> m_tail{ 0 };
+	};
+}
+
+#endif // !SpscQueue_h
@@ -0,0 +1,85 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef StartupScheduler_h
+#define StartupScheduler_h
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace xpilot
+{
+	/**
+	 * Runs plugin startup as named phases from a flight loop callback, so the work is spread
+	 * over the first frames instead of holding up X-Plane while the plugin is enabled.
+	 *
+	 * A phase runs once everything it depends on is done. Its step is called once per frame
+	 * until it returns true; a phase that waits on a thread of its own just returns false
+	 * until that thread is finished. Each frame runs steps until the budget is used up.
+	 * When the last phase is done, a report of every phase goes to Log.txt.
+	 */
+	class StartupScheduler
+	{
+	public:
+		typedef std::function<bool()> Step;
+
+		void add(const std::string& name, const std::vector<std::string>& dependencies, const Step& step);
+
+		/**
+		 * Adds a phase that already ran before the scheduler took over, for the report. The
+		 * report measures the startup from the beginning of the first of these phases.
+		 */
+		void addCompleted(const std::string& name, std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end);
+
+		/**
+		 * Sim thread only. Returns true once every phase is done.
+		 */
+		bool run(std::chrono::microseconds budget);
+
+		bool isFinished()const { return m_finished; }
+
+	private:
+		struct Phase
+		{
+			std::string name;
+			const char* traceName = nullptr;
+			std::vector<std::string> dependencies;
+			Step step;
+			bool done = false;
+			long long startedAt = -1; // microseconds since the plugin was enabled
+			long long finishedAt = 0;
+			long long simMicros = 0;
+			unsigned frames = 0;       // 0 for phases that ran before the scheduler
+		};
+
+		bool isDone(const std::string& name)const;
+		long long sinceEnable(std::chrono::steady_clock::time_point t)const;
+		void report()const;
+
+		std::vector<Phase> m_phases;
+		std::chrono::steady_clock::time_point m_enableTime;
+		bool m_hasEnableTime = false;
+		long long m_firstFrameAt = 0;
+		unsigned m_frames = 0;
+		bool m_finished = false;
+	};
+}
+
+#endif // !StartupScheduler_h
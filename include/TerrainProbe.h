@@ -20,6 +20,7 @@
 #define TerrainProbe_h
 
 #include <array>
+#include <cstdint>
 #include <XPLMScenery.h>
 #include <XPLMGraphics.h>
 
@@ -30,9 +31,14 @@ namespace xpilot
     public:
         TerrainProbe();
         ~TerrainProbe();
+        /** Terrain elevation in feet, or NaN if the probe found no terrain (e.g. scenery not loaded) */
         double getTerrainElevation(double degLat, double degLon)const;
+
+        /** Total number of XPLMProbeTerrainXYZ calls made by all probes (sim thread only) */
+        static uint64_t probeCount() { return s_probeCount; }
     private:
         XPLMProbeRef m_probeRef = nullptr;
+        static uint64_t s_probeCount;
     };
 }
 
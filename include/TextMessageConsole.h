@@ -19,6 +19,9 @@
 #ifndef TextMessageConsole_h
 #define TextMessageConsole_h
 
+#include <cmath>
+#include <deque>
+
 #include "XPImgWindow.h"
 
 namespace xpilot {
@@ -32,6 +35,8 @@ namespace xpilot {
 		double red;
 		double green;
 		double blue;
+		float wrapWidth = -1.0f;
+		float height = 0.0f;
 	public:
 		std::string getMessage() { return message; }
 		float getRed() { return red / 255; }
@@ -41,6 +46,31 @@ namespace xpilot {
 		void setRed(double value) { red = value; }
 		void setGreen(double value) { green = value; }
 		void setBlue(double value) { blue = value; }
+
+		// height of the wrapped text, laid out again only when the width changes by a pixel or more
+		float getHeight(float width)
+		{
+			if (std::fabs(width - wrapWidth) >= 1.0f)
+			{
+				height = ImGui::CalcTextSize(message.c_str(), nullptr, false, width).y;
+				wrapWidth = width;
+			}
+			return height;
+		}
+	};
+
+	/**
+	 * The messages of a console tab, capped at the configured number (oldest dropped first).
+	 * draw() only lays out the messages that are scrolled into view.
+	 */
+	class ConsoleHistory
+	{
+	public:
+		void push(const ConsoleMessage& message);
+		void clear() { m_messages.clear(); }
+		void draw();
+	private:
+		std::deque<ConsoleMessage> m_messages;
 	};
 
 	struct Tab 
@@ -49,7 +79,7 @@ namespace xpilot {
 		std::string textInput;
 		bool isOpen;
 		bool scrollToBottom;
-		std::list<ConsoleMessage> messageHistory;
+		ConsoleHistory messageHistory;
 	};
 
 	enum class ConsoleTabType
@@ -0,0 +1,125 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef Tracer_h
+#define Tracer_h
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace xpilot
+{
+	struct TraceEvent
+	{
+		const char* name;  // a string literal or from Tracer::intern(), only the pointer is stored
+		uint64_t start;    // microseconds since the tracer was created
+		uint64_t duration; // microseconds
+	};
+
+	/**
+	 * Per-thread ring of trace events. Only the owning thread writes to it, so recording
+	 * an event is a couple of stores and never takes a lock. When the thread exits its
+	 * buffer is handed to the next thread that starts recording.
+	 */
+	struct TraceBuffer
+	{
+		static constexpr size_t Capacity = 1 << 16;
+
+		uint32_t threadId = 0;
+		std::string threadName;
+		std::vector<TraceEvent> events;
+		std::atomic<uint64_t> count{ 0 };
+		std::atomic<bool> threadExited{ false };
+	};
+
+	/**
+	 * Opt-in timeline recorder. While enabled, every TraceScope (and ProfileScope) records
+	 * a complete event into its thread's buffer; dump() writes the most recent events of all
+	 * threads in the Chrome trace format, which Perfetto and chrome://tracing can open.
+	 */
+	class Tracer
+	{
+	public:
+		static Tracer& Instance();
+
+		void setEnabled(bool enabled) { m_enabled.store(enabled, std::memory_order_relaxed); }
+		bool isEnabled()const { return m_enabled.load(std::memory_order_relaxed); }
+
+		/**
+		 * Names the calling thread in the exported trace.
+		 */
+		void setThreadName(const std::string& name);
+
+		void record(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+
+		/**
+		 * Returns a copy of the name that lives as long as the tracer, for event names that
+		 * aren't string literals. Takes a lock, so look the name up once rather than per event.
+		 */
+		const char* intern(const std::string& name);
+
+		bool dump(const std::string& path);
+
+	private:
+		Tracer();
+		TraceBuffer* threadBuffer();
+
+		std::atomic<bool> m_enabled{ false };
+		std::chrono::steady_clock::time_point m_origin;
+		std::mutex m_buffersMutex; // only taken when a thread records its first event, and by dump()
+		std::vector<std::unique_ptr<TraceBuffer>> m_buffers;
+		uint32_t m_nextThreadId = 1;
+		std::mutex m_namesMutex;
+		std::set<std::string> m_names;
+	};
+
+	class TraceScope
+	{
+	public:
+		explicit TraceScope(const char* name) :
+			m_name(name),
+			m_active(Tracer::Instance().isEnabled())
+		{
+			if (m_active) m_start = std::chrono::steady_clock::now();
+		}
+
+		~TraceScope()
+		{
+			if (m_active)
+			{
+				Tracer::Instance().record(m_name, m_start, std::chrono::steady_clock::now());
+			}
+		}
+
+		TraceScope(const TraceScope&) = delete;
+		TraceScope& operator=(const TraceScope&) = delete;
+
+	private:
+		const char* m_name;
+		bool m_active;
+		std::chrono::steady_clock::time_point m_start;
+	};
+}
+
+#endif // !Tracer_h
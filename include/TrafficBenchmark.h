@@ -0,0 +1,113 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef TrafficBenchmark_h
+#define TrafficBenchmark_h
+
+#include <string>
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <atomic>
+#include <random>
+#include <chrono>
+#include <functional>
+
+#include "json.hpp"
+#include "Profiler.h"
+
+namespace xpilot
+{
+	/**
+	 * Drives synthetic traffic through the regular message pipeline and measures what
+	 * each frame costs at increasing aircraft counts. Results are written as JSON so
+	 * runs can be compared across builds.
+	 *
+	 * Runs on the sim thread and keeps the profiler enabled while it is running.
+	 */
+	class TrafficBenchmark
+	{
+	public:
+		typedef std::function<void(const std::string&)> MessageHandler;
+		typedef std::function<uint64_t()> AllocationCounter;
+
+		TrafficBenchmark(MessageHandler handler);
+		~TrafficBenchmark();
+
+		bool start(double originLat, double originLon, const std::string& resultPath);
+		void stop();
+		bool isRunning()const { return m_running; }
+
+		/**
+		 * Optional: the number of heap allocations made so far. With a counter, each step also
+		 * reports the allocations per frame, not counting the ones made to generate the traffic.
+		 * The plugin has none; the headless benchmark counts them by replacing operator new.
+		 */
+		void setAllocationCounter(AllocationCounter counter) { m_allocationCounter = counter; }
+
+		void onFrame(const ProfilerFrame& frame);
+
+	private:
+		struct SyntheticAircraft
+		{
+			std::string callsign;
+			std::string typeCode;
+			std::string airline;
+			double latitude;
+			double longitude;
+			double altitude;
+			double heading;
+			double groundSpeed;
+			bool onGround;
+			std::chrono::steady_clock::time_point nextUpdate;
+			std::chrono::steady_clock::time_point lastUpdate;
+		};
+
+		struct StepSamples
+		{
+			std::array<std::vector<long long>, ProfilerStageCount> stages;
+			std::vector<long long> total;
+			std::vector<long long> allocations;
+		};
+
+		void beginStep();
+		void finishStep();
+		void spawnAircraft(size_t count);
+		void sendPosition(SyntheticAircraft& ac, std::chrono::steady_clock::time_point now);
+		void removeAircraft();
+		std::string nextCallsign(std::string& airline);
+		void writeResults();
+
+		MessageHandler m_handler;
+		AllocationCounter m_allocationCounter;
+		uint64_t m_allocationMark = 0;
+		std::mt19937 m_rng;
+		std::atomic<bool> m_running{ false };
+		double m_originLat = 0.0;
+		double m_originLon = 0.0;
+		std::string m_resultPath;
+
+		size_t m_step = 0;
+		std::chrono::steady_clock::time_point m_stepStart;
+		std::vector<SyntheticAircraft> m_aircraft;
+		StepSamples m_samples;
+		nlohmann::json m_results;
+	};
+}
+
+#endif // !TrafficBenchmark_h
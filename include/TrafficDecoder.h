@@ -0,0 +1,53 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef TrafficDecoder_h
+#define TrafficDecoder_h
+
+#include <string>
+#include <functional>
+
+#include "json.hpp"
+using json = nlohmann::json;
+
+namespace xpilot
+{
+	class AircraftManager;
+
+	/**
+	 * Turns the traffic messages from the pilot client (AddPlane, PositionUpdate, ...) into
+	 * calls on the AircraftManager. decode() runs on the socket thread; the calls themselves
+	 * are handed to the dispatcher, which has to run them on the sim thread.
+	 */
+	class TrafficDecoder
+	{
+	public:
+		typedef std::function<void(const std::function<void()>&)> Dispatcher;
+
+		TrafficDecoder(AircraftManager* aircraftManager, Dispatcher dispatcher);
+
+		static bool isTraffic(const std::string& type);
+		void decode(const std::string& type, const json& j, long long receivedAt);
+
+	private:
+		AircraftManager* m_aircraftManager;
+		Dispatcher m_dispatcher;
+	};
+}
+
+#endif // !TrafficDecoder_h
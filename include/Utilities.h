@@ -19,6 +19,7 @@
 #ifndef Utilities_h
 #define Utilities_h
 
+#include <cstring>
 #include <ctime>
 #include <string>
 #include <memory>
@@ -29,6 +30,7 @@
 #include <algorithm>
 #include <vector>
 
+#include "AsyncLog.h"
 #include "Constants.h"
 #include "Config.h"
 #include "XPLMPlugin.h"
@@ -52,8 +54,9 @@ inline bool begins_with(const TContainer& input, const TContainer& match)
 
 inline char* strScpy(char* dest, const char* src, size_t size)
 {
-	strncpy(dest, src, size);
-	dest[size - 1] = 0;
+	const size_t len = strnlen(src, size - 1);
+	memcpy(dest, src, len);
+	dest[len] = 0;
 	return dest;
 }
 
@@ -62,7 +65,15 @@ inline std::string strAtMost(const std::string s, size_t m) {
 		s.substr(0, m - 3) + "...";
 }
 
-#define STRCPY_ATMOST(dest,src) strncpy_s(dest,sizeof(dest),strAtMost(src,sizeof(dest)-1).c_str(),sizeof(dest)-1)
+// src is already cut down to fit, copy it with its terminator
+inline char* strCpyAtMost(char* dest, const std::string& src, size_t size)
+{
+	const std::string s = strAtMost(src, size - 1);
+	memcpy(dest, s.c_str(), s.size() + 1);
+	return dest;
+}
+
+#define STRCPY_ATMOST(dest,src) strCpyAtMost(dest,src,sizeof(dest))
 
 inline const auto str_tolower = [](std::string s) {
 	std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return std::tolower(c); });
@@ -207,41 +218,27 @@ enum logLevel
 
 inline const char* LOG_LEVEL[] = { " DEBUG "," INFO "," WARN "," ERROR "," FATAL ","" };
 
-inline const char* Logger(logLevel level, const char* msg, va_list args)
-{
-	static char buf[2048];
-
-	float secs = GetNetworkTime();
-	const unsigned hours = unsigned(secs / 3600.0f);
-	secs -= hours * 3600.0f;
-	const unsigned mins = unsigned(secs / 60.0f);
-	secs -= mins * 60.0f;
-
-	snprintf(buf, sizeof(buf), "%u:%02u:%06.3f %s: %s", hours, mins, secs, PLUGIN_NAME, LOG_LEVEL[level]);
-	if (args)
-	{
-		vsnprintf(&buf[strlen(buf)], sizeof(buf) - strlen(buf) - 1, msg, args);
-	}
-	size_t length = strlen(buf);
-	if (buf[length - 1] != '\n')
-	{
-		buf[length] = '\n';
-		buf[length + 1] = 0;
-	}
-	return buf;
-}
-
-inline void Log(logLevel level, const char* msg, ...)
+inline void Log(xpilot::LogCategory category, logLevel level, const char* msg, ...)
 {
 	va_list args;
 	va_start(args, msg);
-	XPLMDebugString(Logger(level, msg, args));
+	xpilot::AsyncLog::Instance().write(category, level, msg, args);
 	va_end(args);
 }
 
-#define LOG_MSG(lvl,...)  {        \
-    if (lvl >= xpilot::Config::Instance().getLogLevel()) \
-    {Log(lvl, __VA_ARGS__);}       \
+// levels below this are compiled out of LOG_MSG altogether, arguments included
+#ifndef XPILOT_MIN_LOG_LEVEL
+#define XPILOT_MIN_LOG_LEVEL logDEBUG
+#endif
+
+#define LOG_CAT(cat,lvl,...)  {    \
+    if constexpr (lvl >= XPILOT_MIN_LOG_LEVEL) \
+    {                              \
+        if (xpilot::AsyncLog::Instance().isEnabled(xpilot::LogCategory::cat, lvl)) \
+        {Log(xpilot::LogCategory::cat, lvl, __VA_ARGS__);} \
+    }                              \
 }
 
+#define LOG_MSG(lvl,...) LOG_CAT(General, lvl, __VA_ARGS__)
+
 #endif // !Utilities_h
\ No newline at end of file
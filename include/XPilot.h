@@ -34,8 +34,8 @@
 
 #include "DataRefAccess.h"
 #include "OwnedDataRef.h"
+#include "StartupScheduler.h"
 #include "TextMessageConsole.h"
-#include "ZMQ/zmq.hpp"
 
 #include "XPLMMenus.h"
 #include "XPLMUtilities.h"
@@ -56,6 +56,16 @@ namespace xpilot
 	class TextMessageConsole;
 	class NearbyATCWindow;
 	class SettingsWindow;
+	class DiagnosticsWindow;
+	class PerformanceMonitor;
+	class ZmqReactor;
+	class OwnshipTelemetry;
+	class SessionRecorder;
+	class SessionPlayer;
+	class TrafficBenchmark;
+	class TrafficDecoder;
+	class CslLoader;
+	class PluginHash;
 
 	class XPilot
 	{
@@ -104,11 +114,20 @@ namespace xpilot
 		void togglePreferencesWindow();
 		void toggleNearbyAtcWindow();
 		void toggleTextMessageConsole();
+		void toggleDiagnosticsWindow();
+		void toggleTracing();
+		bool isTracing()const;
+		void saveTrace();
 		void setNotificationPanelAlwaysVisible(bool visible);
 		bool setNotificationPanelAlwaysVisible()const;
 
 		void startZmqServer();
 		void stopZmqServer();
+
+		void toggleSessionRecording();
+		bool isSessionRecording()const;
+		void replaySession(double speed);
+		void toggleTrafficBenchmark();
 	protected:
 		OwnedDataRef<int> m_pttPressed;
 		OwnedDataRef<int> m_networkLoginStatus;
@@ -122,10 +141,11 @@ namespace xpilot
 		DataRefAccess<int> m_xplaneAtisEnabled;
 
 	private:
-		std::string pluginHash;
 		static float deferredStartup(float, float, int, void* ref);
 		static float onFlightLoop(float, float, int, void* ref);
 		bool initializeXPMP();
+		void createWindows();
+		StartupScheduler m_startup;
 
 		std::thread::id m_xplaneThread;
 		void thisThreadIsXP()
@@ -137,24 +157,19 @@ namespace xpilot
 			return std::this_thread::get_id() == m_xplaneThread;
 		}
 
-		bool m_keepAlive;
-		std::unique_ptr<std::thread> m_zmqThread;
-		std::unique_ptr<zmq::context_t> m_zmqContext;
-		std::unique_ptr<zmq::socket_t> m_zmqSocket;
-
-		void zmqWorker();
-		bool isSocketConnected()const
-		{
-			return m_zmqSocket && m_zmqSocket->connected();
-		}
-		bool isSocketReady()const
-		{
-			return m_keepAlive && isSocketConnected();
-		}
+		std::unique_ptr<ZmqReactor> m_zmqReactor;
+		std::unique_ptr<OwnshipTelemetry> m_ownshipTelemetry;
+		std::unique_ptr<SessionRecorder> m_sessionRecorder;
+		std::unique_ptr<SessionPlayer> m_sessionPlayer;
+		std::unique_ptr<TrafficBenchmark> m_trafficBenchmark;
+		std::unique_ptr<CslLoader> m_cslLoader;
+		std::unique_ptr<PluginHash> m_pluginHash;
+		void processMessage(const std::string& data);
+		void processReplayedMessage(const std::string& data);
 
 		std::mutex m_mutex;
 		std::deque<std::function<void()>> m_queuedCallbacks;
-		void invokeQueuedCallbacks();
+		size_t invokeQueuedCallbacks();
 		void queueCallback(const std::function<void()> &cb);
 
 		XPLMDataRef m_bulkDataQuick{}, m_bulkDataExpensive{};
@@ -163,10 +178,13 @@ namespace xpilot
 
 		std::unique_ptr<FrameRateMonitor> m_frameRateMonitor;
 		std::unique_ptr<AircraftManager> m_aircraftManager;
+		std::unique_ptr<TrafficDecoder> m_trafficDecoder;
 		std::unique_ptr<NotificationPanel> m_notificationPanel;
 		std::unique_ptr<TextMessageConsole> m_textMessageConsole;
 		std::unique_ptr<NearbyATCWindow> m_nearbyAtcWindow;
 		std::unique_ptr<SettingsWindow> m_settingsWindow;
+		std::unique_ptr<DiagnosticsWindow> m_diagnosticsWindow;
+		std::unique_ptr<PerformanceMonitor> m_performanceMonitor;
 	};
 }
 
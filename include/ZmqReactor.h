@@ -0,0 +1,172 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef ZmqReactor_h
+#define ZmqReactor_h
+
+#include <string>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <algorithm>
+
+#include "Compression.h"
+#include "ZMQ/zmq.hpp"
+
+namespace xpilot
+{
+	/**
+	 * Single-threaded I/O loop for the pilot client socket.
+	 *
+	 * The I/O thread owns the ROUTER socket and multiplexes inbound messages,
+	 * the outbound queue and control commands with zmq_poll. Other threads never
+	 * touch the ROUTER socket; they queue outbound messages and wake the loop
+	 * through an inproc PAIR socket, which also carries the stop command so
+	 * shutdown never depends on tearing the context down underneath a blocked recv.
+	 */
+	class ZmqReactor
+	{
+	public:
+		typedef std::function<void(const std::string&)> MessageHandler;
+		typedef std::function<bool(std::string&)> OutboundSource;
+
+		struct Stats
+		{
+			std::atomic<uint64_t> iterations{ 0 };  // poll loop iterations
+			std::atomic<uint64_t> wakeups{ 0 };     // iterations woken by the control socket
+			std::atomic<uint64_t> timeouts{ 0 };    // iterations that returned without any event
+			std::atomic<uint64_t> messagesIn{ 0 };
+			std::atomic<uint64_t> messagesOut{ 0 };
+			std::atomic<uint64_t> bytesIn{ 0 };
+			std::atomic<uint64_t> bytesOut{ 0 };
+			std::atomic<uint64_t> compressedIn{ 0 };       // inbound frames that arrived compressed
+			std::atomic<uint64_t> compressedOut{ 0 };      // outbound messages sent compressed
+			std::atomic<uint64_t> uncompressedBytesOut{ 0 }; // payload bytes before compression
+			std::atomic<uint64_t> maxBatch{ 0 };    // largest number of messages handled in one iteration
+			std::atomic<uint64_t> busyMicros{ 0 };  // time spent outside of zmq_poll
+		};
+
+		ZmqReactor(MessageHandler handler, size_t batchSize = DefaultBatchSize);
+		~ZmqReactor();
+
+		ZmqReactor(const ZmqReactor&) = delete;
+		ZmqReactor& operator=(const ZmqReactor&) = delete;
+
+		/**
+		 * Binds the ROUTER socket and starts the I/O thread. A running reactor is
+		 * stopped first, so this can also be used to restart on a different port.
+		 */
+		bool start(const std::string& endpoint);
+
+		/**
+		 * Stops the I/O thread and closes all sockets. Returns within one poll
+		 * batch plus PollTimeoutMs, regardless of whether a client is connected.
+		 */
+		void stop();
+
+		/**
+		 * Queues a message for the pilot client. Safe to call from any thread.
+		 */
+		void send(const std::string& msg);
+
+		/**
+		 * Registers a lock-free producer that is drained by the I/O thread after the
+		 * outbound queue. The source returns false once it has nothing left to send.
+		 * Must be set while the reactor is stopped.
+		 */
+		void setOutboundSource(OutboundSource source)
+		{
+			m_outboundSource = source;
+		}
+
+		/**
+		 * Enables LZ4 compression of outbound messages of at least threshold bytes,
+		 * as negotiated with the client. Compressed inbound frames are always accepted.
+		 */
+		void setCompression(bool enabled, size_t threshold = DefaultCompressionThreshold)
+		{
+			m_compressionThreshold = (std::max)(threshold, MinCompressionThreshold);
+			m_compressionEnabled = enabled;
+		}
+
+		bool isCompressionEnabled()const
+		{
+			return m_compressionEnabled;
+		}
+
+		/**
+		 * Wakes the I/O thread, e.g. after an outbound source produced new data. Wake-ups
+		 * coalesce until the I/O thread runs, and never wait for the outbox lock.
+		 */
+		void wake()
+		{
+			signal(CmdWake);
+		}
+
+		bool isRunning()const
+		{
+			return m_running;
+		}
+
+		const Stats& stats()const
+		{
+			return m_stats;
+		}
+
+		static constexpr size_t DefaultBatchSize = 64;
+		static constexpr long PollTimeoutMs = 250;
+
+	private:
+		enum ControlCommand : char
+		{
+			CmdWake = 'W',
+			CmdStop = 'S'
+		};
+
+		void run();
+		void signal(ControlCommand cmd);
+		size_t drainInbound();
+		size_t drainOutbound(bool& backlog);
+
+		MessageHandler m_handler;
+		OutboundSource m_outboundSource;
+		size_t m_batchSize;
+		std::string m_wakeEndpoint;
+
+		std::unique_ptr<zmq::context_t> m_context;
+		std::unique_ptr<zmq::socket_t> m_router;
+		std::unique_ptr<zmq::socket_t> m_wakeRecv;
+		std::unique_ptr<zmq::socket_t> m_wakeSend;
+		std::unique_ptr<std::thread> m_thread;
+		std::atomic<bool> m_running{ false };
+		std::atomic<bool> m_wakePending{ false };
+		std::atomic<bool> m_compressionEnabled{ false };
+		std::atomic<size_t> m_compressionThreshold{ DefaultCompressionThreshold };
+
+		std::mutex m_wakeMutex; // guards m_wakeSend, which any thread may signal through
+		std::mutex m_outboxMutex;
+		std::deque<std::string> m_outbox;
+
+		Stats m_stats;
+	};
+}
+
+#endif // !ZmqReactor_h
@@ -16,9 +16,16 @@
  * along with this program. If not, see http://www.gnu.org/licenses/.
 */
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 #include "AircraftManager.h"
 #include "NetworkAircraft.h"
 #include "Utilities.h"
+#include "Config.h"
+#include "LatencyTracker.h"
+#include "ModelMatchCache.h"
 
 namespace xpilot
 {
@@ -41,90 +48,194 @@ namespace xpilot
 
 	void AircraftManager::interpolateAirplanes()
 	{
+		const InterpolationMode mode = Config::Instance().getCubicInterpolation() ? InterpolationMode::Cubic : InterpolationMode::Linear;
+		const auto now = std::chrono::steady_clock::now();
+
 		for (auto& kv : mapPlanes)
 		{
 			NetworkAircraft* plane = kv.second.get();
 			if (!plane) continue;
 
-			if (plane->interpolationStack.size() > 0)
+			long long currentTimestamp = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+			if (plane->fastPositionActive && now - plane->lastFastPositionUpdate > FastPositionTimeout)
 			{
-				InterpolatedState interpolated;
-				long long currentTimestamp = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+				// fast updates stopped (e.g. the aircraft moved out of range); hand over to the
+				// regular updates from where the aircraft is drawn now, without a jump
+				plane->fastPositionActive = false;
+				InterpolatedState drawn = fastPositionState(plane, currentTimestamp);
+				drawn.rendered = true;
+				plane->interpolationStack.clear();
+				plane->interpolationStack.push_back(drawn);
+			}
 
-				if (plane->interpolationStack.size() == 1)
-				{
-					interpolated = plane->interpolationStack.front();
-				}
-				else if (currentTimestamp <= plane->interpolationStack.front().timestamp)
-				{
-					interpolated = plane->interpolationStack.front();
-				}
-				else
-				{
-					InterpolatedState start{};
-					InterpolatedState end{};
-
-					for (int i = 0; i < plane->interpolationStack.size() - 1; i++)
-					{
-						start = plane->interpolationStack.at(i);
-						end = plane->interpolationStack.at(i + 1.0);
-						if ((start.timestamp < currentTimestamp) && (end.timestamp >= currentTimestamp))
-						{
-							break;
-						}
-					}
-
-					if (currentTimestamp <= start.timestamp)
-					{
-						interpolated = start;
-					}
-					else if (currentTimestamp >= end.timestamp)
-					{
-						interpolated = end;
-					}
-					else
-					{
-						long long timeDelta = end.timestamp - start.timestamp;
-						double pct = (currentTimestamp - start.timestamp) / (double)timeDelta;
-						double startHeaing = start.heading;
-						double endHeading = end.heading;
-						if (abs(endHeading - startHeaing) > 180.0)
-						{
-							endHeading += (endHeading > startHeaing ? -360.0 : 360.0);
-						}
-						interpolated.timestamp = currentTimestamp;
-						interpolated.latitude = start.latitude + ((end.latitude - start.latitude) * pct);
-						interpolated.longitude = start.longitude + ((end.longitude - start.longitude) * pct);
-						interpolated.altitude = start.altitude + ((end.altitude - start.altitude) * pct);
-						interpolated.pitch = start.pitch + ((end.pitch - start.pitch) * pct);
-						interpolated.bank = start.bank + ((end.bank - start.bank) * pct);
-						interpolated.heading = NormalizeHeading(startHeaing + ((endHeading - startHeaing) * pct));
-						interpolated.groundSpeed = start.groundSpeed + ((end.groundSpeed - start.groundSpeed) * pct);
-					}
-				}
-				plane->position.lat = interpolated.latitude;
-				plane->position.lon = interpolated.longitude;
-				plane->position.elevation = interpolated.altitude;
-				plane->position.heading = static_cast<float>(interpolated.heading);
-				plane->position.roll = static_cast<float>(interpolated.bank);
-				plane->position.pitch = static_cast<float>(interpolated.pitch);
-				plane->groundSpeed = static_cast<float>(interpolated.groundSpeed);
+			InterpolatedState interpolated{};
+			if (plane->fastPositionActive)
+			{
+				interpolated = fastPositionState(plane, currentTimestamp);
+			}
+			else if (plane->interpolationStack.size() > 0)
+			{
+				interpolated = InterpolateState(plane->interpolationStack, currentTimestamp, mode);
+				trackLatency(plane, currentTimestamp);
+			}
+			else
+			{
+				continue;
+			}
+
+			plane->position.lat = interpolated.latitude;
+			plane->position.lon = interpolated.longitude;
+			plane->position.elevation = interpolated.altitude;
+			plane->position.heading = static_cast<float>(interpolated.heading);
+			plane->position.roll = static_cast<float>(interpolated.bank);
+			plane->position.pitch = static_cast<float>(interpolated.pitch);
+			plane->groundSpeed = static_cast<float>(interpolated.groundSpeed);
+		}
+
+		followTerrain();
+		m_modelResidency.update();
+	}
+
+	void AircraftManager::followTerrain()
+	{
+		// on-ground aircraft are put on the terrain under their interpolated position every
+		// frame; XPMP2 then lifts them by the CSL model's vertical offset so the gear touches
+		// it. Probing is expensive, so only the aircraft that moved the most since their last
+		// probe are probed each frame and the others keep their last elevation.
+		m_groundProbeCandidates.clear();
+		for (auto& kv : mapPlanes)
+		{
+			NetworkAircraft* plane = kv.second.get();
+			if (!plane || !plane->onGround) continue;
+
+			double moved = std::numeric_limits<double>::max();
+			if (plane->hasGroundProbe)
+			{
+				constexpr double MetersPerDegree = 111120.0;
+				constexpr double RadiansPerDegree = 3.14159265358979323846 / 180.0;
+				const double dLat = (plane->position.lat - plane->groundProbeLatitude) * MetersPerDegree;
+				const double dLon = (plane->position.lon - plane->groundProbeLongitude) * MetersPerDegree * std::cos(plane->position.lat * RadiansPerDegree);
+				moved = std::sqrt(dLat * dLat + dLon * dLon);
+			}
+			if (moved >= MinGroundProbeDistance)
+			{
+				m_groundProbeCandidates.emplace_back(moved, plane);
+			}
+		}
+
+		const size_t probes = (std::min)(GroundProbeBudget, m_groundProbeCandidates.size());
+		std::partial_sort(m_groundProbeCandidates.begin(), m_groundProbeCandidates.begin() + probes, m_groundProbeCandidates.end(),
+			[](const std::pair<double, NetworkAircraft*>& a, const std::pair<double, NetworkAircraft*>& b) { return a.first > b.first; });
+
+		for (size_t i = 0; i < probes; i++)
+		{
+			NetworkAircraft* plane = m_groundProbeCandidates[i].second;
+			const double elevation = plane->terrainProbe.getTerrainElevation(plane->position.lat, plane->position.lon);
+			if (std::isnan(elevation)) continue;
+
+			plane->hasGroundProbe = true;
+			plane->groundProbeLatitude = plane->position.lat;
+			plane->groundProbeLongitude = plane->position.lon;
+			plane->groundProbeElevation = elevation;
+			plane->terrainAltitude = elevation;
+		}
+
+		for (auto& kv : mapPlanes)
+		{
+			NetworkAircraft* plane = kv.second.get();
+			if (plane && plane->onGround && plane->hasGroundProbe)
+			{
+				plane->position.elevation = plane->groundProbeElevation;
 			}
 		}
 	}
 
+	InterpolatedState AircraftManager::fastPositionState(const NetworkAircraft* plane, long long currentTimestamp)
+	{
+		InterpolatedState state = ProjectVelocityState(plane->fastPosition, currentTimestamp);
+
+		// fade out the difference to where the aircraft was drawn when the last sample came in
+		const double remaining = 1.0 - (currentTimestamp - plane->fastPositionErrorAt) / static_cast<double>(FastPositionCorrectionTime);
+		if (remaining > 0.0)
+		{
+			state = ApplyStateError(state, plane->fastPositionError, (std::min)(remaining, 1.0));
+		}
+		return state;
+	}
+
+	void AircraftManager::trackLatency(NetworkAircraft* plane, long long currentTimestamp)
+	{
+		LatencyTracker& latency = LatencyTracker::Instance();
+		std::deque<InterpolatedState>& stack = plane->interpolationStack;
+
+		// a state is first rendered once it becomes the end of the segment being interpolated
+		const long long now = SteadyMicros();
+		for (size_t i = 0; i < stack.size(); i++)
+		{
+			if (i > 0 && stack[i - 1].timestamp >= currentTimestamp)
+				break;
+			if (!stack[i].rendered && stack[i].receivedAt > 0)
+			{
+				stack[i].rendered = true;
+				latency.record(LatencyHop::Buffer, now - stack[i].dequeuedAt);
+				latency.record(LatencyHop::EndToEnd, now - stack[i].receivedAt);
+			}
+		}
+
+		// holding the last known state because the next one hasn't arrived in time
+		const bool underrun = stack.size() > 1 && currentTimestamp > stack.back().timestamp;
+		if (underrun && !plane->interpolationUnderrun)
+		{
+			latency.recordUnderrun();
+		}
+		plane->interpolationUnderrun = underrun;
+	}
+
 	void AircraftManager::addNewPlane(const std::string& callsign, const std::string& typeIcao,
 		const std::string& airlineIcao, const std::string& livery, const std::string& model)
 	{
 		auto planeIt = mapPlanes.find(callsign);
 		if (planeIt != mapPlanes.end()) return;
 
-		NetworkAircraft* plane = new NetworkAircraft(typeIcao.c_str(), airlineIcao.c_str(), livery.c_str(), 0, model.c_str());
+		NetworkAircraft* plane = nullptr;
+		if (Config::Instance().getModelLoadDistance() > 0)
+		{
+			// start out with the placeholder; ModelResidency assigns the real model once in range
+			std::string placeholderId;
+			ModelMatchCache::Instance().find(typeIcao, "", "", placeholderId);
+			plane = new NetworkAircraft(typeIcao.c_str(), "", "", 0, placeholderId.c_str());
+			const std::string cslId = plane->GetModelInfo().cslId;
+			if (cslId != placeholderId)
+			{
+				ModelMatchCache::Instance().store(typeIcao, "", "", cslId);
+			}
+			plane->acIcaoAirline = airlineIcao;
+			plane->acLivery = livery;
+			plane->modelDeferred = true;
+			plane->requestedModel = model;
+		}
+		else
+		{
+			// an explicitly requested model skips matching anyway
+			std::string modelId = model;
+			const bool cached = !modelId.empty() || ModelMatchCache::Instance().find(typeIcao, airlineIcao, livery, modelId);
+
+			plane = new NetworkAircraft(typeIcao.c_str(), airlineIcao.c_str(), livery.c_str(), 0, modelId.c_str());
+
+			// XPMP2 falls back to a full search when the given model doesn't exist (anymore)
+			const std::string cslId = plane->GetModelInfo().cslId;
+			if (!cached || (model.empty() && cslId != modelId))
+			{
+				ModelMatchCache::Instance().store(typeIcao, airlineIcao, livery, cslId);
+			}
+		}
 		plane->callsign = callsign;
 		mapPlanes.emplace(callsign, std::move(plane));
 	}
 
-	void AircraftManager::setPlanePosition(const std::string& callsign, XPMPPlanePosition_t pos, XPMPPlaneRadar_t radar, float groundSpeed, const std::string& origin, const std::string& destination)
+	void AircraftManager::setPlanePosition(const std::string& callsign, XPMPPlanePosition_t pos, XPMPPlaneRadar_t radar, float groundSpeed, const std::string& origin, const std::string& destination,
+		long long sourceTimestamp, long long receivedAt, long long dequeuedAt)
 	{
 		auto planeIt = mapPlanes.find(callsign);
 		if (planeIt == mapPlanes.end()) return;
@@ -132,8 +243,58 @@ namespace xpilot
 		NetworkAircraft* plane = planeIt->second.get();
 		if (!plane) return;
 
+		// stale or duplicated updates would only drag the aircraft backwards
+		if (sourceTimestamp > 0 && sourceTimestamp <= plane->lastSourceTimestamp) return;
+
+		LatencyTracker& latency = LatencyTracker::Instance();
+		latency.recordUpdate();
+
+		const long long currentTimestamp = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+		// when the message came off the socket, on the interpolation (wall clock) timeline
+		const long long receivedTimestamp = currentTimestamp - (SteadyMicros() - receivedAt);
+
 		InterpolatedState state{};
-		state.timestamp = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count() + 5500000;
+		if (sourceTimestamp > 0)
+		{
+			// place the state by when the client sampled it, so delivery and queueing jitter
+			// doesn't end up in the rendered motion
+			m_clockOffset.addSample(receivedTimestamp, sourceTimestamp);
+			const long long sampledAt = m_clockOffset.toLocal(sourceTimestamp);
+			state.timestamp = sampledAt + latency.bufferDelay();
+
+			// what the buffer has to cover is the time from the previous sample until this
+			// one arrived, regardless of how late the previous one was
+			if (plane->lastSourceTimestamp > 0)
+			{
+				latency.recordArrivalGap(receivedTimestamp - m_clockOffset.toLocal(plane->lastSourceTimestamp));
+			}
+			plane->lastSourceTimestamp = sourceTimestamp;
+		}
+		else
+		{
+			state.timestamp = currentTimestamp + latency.bufferDelay();
+			if (plane->lastReceivedAt > 0)
+			{
+				latency.recordArrivalGap(receivedAt - plane->lastReceivedAt);
+			}
+		}
+		plane->lastReceivedAt = receivedAt;
+
+		if (plane->interpolationStack.size() > 1 && currentTimestamp > plane->interpolationStack.back().timestamp)
+		{
+			// the aircraft is being dead-reckoned; carry on from where it is drawn right now
+			// rather than snapping back onto the line between the last two snapshots
+			plane->interpolationStack.push_back(InterpolateState(plane->interpolationStack, currentTimestamp));
+		}
+
+		if (!plane->interpolationStack.empty())
+		{
+			// a shrinking buffer delay must never reorder the stack
+			state.timestamp = (std::max)(state.timestamp, plane->interpolationStack.back().timestamp + 1000);
+		}
+		state.receivedAt = receivedAt;
+		state.dequeuedAt = dequeuedAt;
 		state.latitude = pos.lat;
 		state.longitude = pos.lon;
 		state.bank = pos.roll;
@@ -145,7 +306,7 @@ namespace xpilot
 		groundElevation = plane->terrainProbe.getTerrainElevation(pos.lat, pos.lon);
 		if (std::isnan(groundElevation))
 		{
-			groundElevation = 0.0;
+			groundElevation = plane->terrainAltitude;
 		}
 
 		plane->origin = origin.empty() ? "" : origin;
@@ -157,12 +318,51 @@ namespace xpilot
 		plane->renderCount++;
 
 		plane->interpolationStack.push_back(state);
-		while (plane->interpolationStack.size() > 2
-			&& plane->interpolationStack.at(1).timestamp
-			<= std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count())
+		PruneInterpolationStack(plane->interpolationStack, currentTimestamp);
+	}
+
+	void AircraftManager::setPlaneFastPosition(const std::string& callsign, VelocityState state, long long sourceTimestamp, long long receivedAt)
+	{
+		auto planeIt = mapPlanes.find(callsign);
+		if (planeIt == mapPlanes.end()) return;
+
+		NetworkAircraft* plane = planeIt->second.get();
+		if (!plane) return;
+
+		// the regular updates place the aircraft first, its model and surfaces depend on that
+		if (plane->renderCount == 0) return;
+
+		const long long currentTimestamp = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+		const long long receivedTimestamp = currentTimestamp - (SteadyMicros() - receivedAt);
+
+		// fast updates are drawn as soon as they arrive, advanced by their velocities to the
+		// current frame, so there is no interpolation delay to add
+		if (sourceTimestamp > 0)
 		{
-			plane->interpolationStack.pop_front();
+			m_clockOffset.addSample(receivedTimestamp, sourceTimestamp);
+			state.sample.timestamp = m_clockOffset.toLocal(sourceTimestamp);
 		}
+		else
+		{
+			state.sample.timestamp = receivedTimestamp;
+		}
+
+		if (plane->fastPositionActive && state.sample.timestamp <= plane->fastPosition.sample.timestamp) return;
+
+		// whatever is on screen now is where the correction starts from
+		InterpolatedState drawn{};
+		drawn.latitude = plane->position.lat;
+		drawn.longitude = plane->position.lon;
+		drawn.altitude = plane->position.elevation;
+		drawn.heading = plane->position.heading;
+		drawn.pitch = plane->position.pitch;
+		drawn.bank = plane->position.roll;
+
+		plane->fastPosition = state;
+		plane->fastPositionError = StateError(drawn, ProjectVelocityState(state, currentTimestamp));
+		plane->fastPositionErrorAt = currentTimestamp;
+		plane->fastPositionActive = true;
+		plane->lastFastPositionUpdate = std::chrono::steady_clock::now();
 	}
 
 	void AircraftManager::updateAircraftConfig(const std::string& callsign, const NetworkAircraftConfig& config)
@@ -280,6 +480,17 @@ namespace xpilot
 		NetworkAircraft* plane = planeIt->second.get();
 		if (!plane) return;
 
-		plane->ChangeModel(typeIcao.c_str(), airlineIcao.c_str(), "");
+		plane->requestedModel.clear();
+		if (plane->modelDeferred)
+		{
+			plane->acIcaoType = typeIcao;
+			plane->acIcaoAirline = airlineIcao;
+			plane->acLivery.clear();
+			ModelResidency::showPlaceholder(plane);
+		}
+		else
+		{
+			ModelResidency::loadModel(plane, typeIcao, airlineIcao, "");
+		}
 	}
 }
\ No newline at end of file
@@ -0,0 +1,191 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include <algorithm>
+#include <cstdio>
+
+#include "AsyncLog.h"
+#include "Utilities.h"
+
+namespace xpilot
+{
+	namespace
+	{
+		thread_local void* CurrentThreadRing = nullptr;
+
+		// marks the thread's ring for reuse when the thread exits
+		struct ThreadRingOwner
+		{
+			std::atomic<bool>* threadExited = nullptr;
+			~ThreadRingOwner()
+			{
+				if (threadExited) threadExited->store(true, std::memory_order_release);
+			}
+		};
+		thread_local ThreadRingOwner CurrentThreadRingOwner;
+	}
+
+	const char* LogCategoryName(LogCategory category)
+	{
+		switch (category)
+		{
+		case LogCategory::General: return "general";
+		case LogCategory::Network: return "net";
+		case LogCategory::Interpolation: return "interp";
+		case LogCategory::Terrain: return "terrain";
+		case LogCategory::Csl: return "csl";
+		case LogCategory::Ui: return "ui";
+		default: return "";
+		}
+	}
+
+	AsyncLog::AsyncLog()
+	{
+		// Warning, like Config until it is loaded
+		for (std::atomic<int>& level : m_levels)
+		{
+			level.store(logWARN, std::memory_order_relaxed);
+		}
+	}
+
+	void AsyncLog::setLevel(LogCategory category, int level)
+	{
+		m_levels[static_cast<size_t>(category)].store(level, std::memory_order_relaxed);
+	}
+
+	AsyncLog& AsyncLog::Instance()
+	{
+		static auto&& log = AsyncLog();
+		return log;
+	}
+
+	AsyncLog::ThreadRing* AsyncLog::threadRing()
+	{
+		if (!CurrentThreadRing)
+		{
+			std::lock_guard<std::mutex> lock(m_ringsMutex);
+
+			// flush() holds the lock while it pops, so an exited thread's ring that is empty
+			// now stays empty and can take a new producer
+			ThreadRing* ring = nullptr;
+			for (const auto& r : m_rings)
+			{
+				if (r->threadExited.load(std::memory_order_acquire) && r->records.empty())
+				{
+					ring = r.get();
+					ring->threadExited.store(false, std::memory_order_relaxed);
+					break;
+				}
+			}
+			if (!ring)
+			{
+				m_rings.push_back(std::make_unique<ThreadRing>());
+				ring = m_rings.back().get();
+			}
+
+			CurrentThreadRing = ring;
+			CurrentThreadRingOwner.threadExited = &ring->threadExited;
+		}
+		return static_cast<ThreadRing*>(CurrentThreadRing);
+	}
+
+	void AsyncLog::write(LogCategory category, int level, const char* msg, va_list args)
+	{
+		LogRecord record;
+		record.time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		record.level = level;
+		record.category = category;
+		vsnprintf(record.text, sizeof(record.text), msg, args);
+
+		ThreadRing* ring = threadRing();
+		if (!ring->records.push(record))
+		{
+			ring->dropped.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	void AsyncLog::flush(std::chrono::microseconds budget)
+	{
+		flushUntil(std::chrono::steady_clock::now() + budget);
+	}
+
+	void AsyncLog::flushAll()
+	{
+		flushUntil(std::chrono::steady_clock::time_point::max());
+	}
+
+	void AsyncLog::flushUntil(std::chrono::steady_clock::time_point deadline)
+	{
+		uint32_t dropped = 0;
+		m_batch.clear();
+		{
+			std::lock_guard<std::mutex> lock(m_ringsMutex);
+			for (const auto& ring : m_rings)
+			{
+				LogRecord record;
+				while (std::chrono::steady_clock::now() < deadline && ring->records.pop(record))
+				{
+					m_batch.push_back(record);
+				}
+				dropped += ring->dropped.exchange(0, std::memory_order_relaxed);
+			}
+		}
+		if (m_batch.empty() && dropped == 0)
+			return;
+
+		// interleave the threads again
+		std::stable_sort(m_batch.begin(), m_batch.end(), [](const LogRecord& a, const LogRecord& b) { return a.time < b.time; });
+
+		// network time is a dataref, so it's read here rather than by whoever logged
+		const float networkTime = GetNetworkTime();
+		const long long now = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+
+		m_text.clear();
+		char prefix[64];
+		for (const LogRecord& record : m_batch)
+		{
+			float secs = (std::max)(0.0f, networkTime - (now - record.time) / 1000000.0f);
+			const unsigned hours = unsigned(secs / 3600.0f);
+			secs -= hours * 3600.0f;
+			const unsigned mins = unsigned(secs / 60.0f);
+			secs -= mins * 60.0f;
+
+			snprintf(prefix, sizeof(prefix), "%u:%02u:%06.3f ", hours, mins, secs);
+			m_text += prefix;
+			m_text += PLUGIN_NAME;
+			m_text += ": ";
+			m_text += LOG_LEVEL[record.level];
+			if (record.category != LogCategory::General)
+			{
+				m_text += '[';
+				m_text += LogCategoryName(record.category);
+				m_text += "] ";
+			}
+			m_text += record.text;
+			if (m_text.back() != '\n')
+			{
+				m_text += '\n';
+			}
+		}
+		if (dropped > 0)
+		{
+			m_text += string_format("%s: %u log message(s) dropped, logging faster than Log.txt is written\n", PLUGIN_NAME, dropped);
+		}
+		XPLMDebugString(m_text.c_str());
+	}
+}
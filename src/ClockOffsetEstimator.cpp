@@ -0,0 +1,45 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include <cstdlib>
+
+#include "ClockOffsetEstimator.h"
+
+namespace xpilot
+{
+	void ClockOffsetEstimator::addSample(long long localTime, long long remoteTime)
+	{
+		const long long observed = localTime - remoteTime;
+
+		if (hasEstimate() && std::llabs(observed - offset()) > MaxDeviation)
+		{
+			reset();
+		}
+
+		while (!m_window.empty() && m_window.back().offset >= observed)
+		{
+			m_window.pop_back();
+		}
+		m_window.push_back({ localTime, observed });
+
+		while (m_window.front().localTime < localTime - Window)
+		{
+			m_window.pop_front();
+		}
+	}
+}
@@ -0,0 +1,228 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include <array>
+#include <cstring>
+
+#include "Compression.h"
+
+namespace xpilot
+{
+	namespace
+	{
+		constexpr size_t MinMatch = 4;
+		constexpr size_t LastLiterals = 5;  // the last 5 bytes of a block are always literals
+		constexpr size_t MatchFindLimit = 12; // no match may start within the last 12 bytes
+		constexpr size_t MaxOffset = 65535;
+		constexpr int HashLog = 12;
+
+		inline uint32_t read32(const uint8_t* p)
+		{
+			uint32_t v;
+			std::memcpy(&v, p, sizeof(v));
+			return v;
+		}
+
+		inline uint32_t hash32(uint32_t sequence)
+		{
+			return (sequence * 2654435761u) >> (32 - HashLog);
+		}
+
+		inline void writeLength(std::string& dst, size_t len)
+		{
+			while (len >= 255)
+			{
+				dst.push_back(static_cast<char>(255));
+				len -= 255;
+			}
+			dst.push_back(static_cast<char>(len));
+		}
+
+		void writeSequence(std::string& dst, const uint8_t* literals, size_t literalLen, size_t offset, size_t matchLen)
+		{
+			const size_t ml = matchLen - MinMatch;
+			const uint8_t token = static_cast<uint8_t>(((literalLen < 15 ? literalLen : 15) << 4) | (ml < 15 ? ml : 15));
+			dst.push_back(static_cast<char>(token));
+			if (literalLen >= 15)
+			{
+				writeLength(dst, literalLen - 15);
+			}
+			dst.append(reinterpret_cast<const char*>(literals), literalLen);
+			dst.push_back(static_cast<char>(offset & 0xFF));
+			dst.push_back(static_cast<char>((offset >> 8) & 0xFF));
+			if (ml >= 15)
+			{
+				writeLength(dst, ml - 15);
+			}
+		}
+
+		void writeLastLiterals(std::string& dst, const uint8_t* literals, size_t literalLen)
+		{
+			dst.push_back(static_cast<char>((literalLen < 15 ? literalLen : 15) << 4));
+			if (literalLen >= 15)
+			{
+				writeLength(dst, literalLen - 15);
+			}
+			dst.append(reinterpret_cast<const char*>(literals), literalLen);
+		}
+
+		bool readLength(const uint8_t* src, size_t srcSize, size_t& ip, size_t& len)
+		{
+			uint8_t b;
+			do
+			{
+				if (ip >= srcSize)
+					return false;
+				b = src[ip++];
+				len += b;
+			} while (b == 255);
+			return true;
+		}
+	}
+
+	void Lz4CompressBlock(const uint8_t* src, size_t srcSize, std::string& dst)
+	{
+		dst.clear();
+		dst.reserve(srcSize + srcSize / 255 + 16);
+
+		size_t anchor = 0;
+		if (srcSize > MatchFindLimit)
+		{
+			std::array<int32_t, 1 << HashLog> table;
+			table.fill(-1);
+
+			const size_t matchLimit = srcSize - LastLiterals;
+			const size_t inputLimit = srcSize - MatchFindLimit;
+			size_t ip = 0;
+
+			while (ip < inputLimit)
+			{
+				const uint32_t sequence = read32(src + ip);
+				const uint32_t h = hash32(sequence);
+				const int32_t ref = table[h];
+				table[h] = static_cast<int32_t>(ip);
+
+				if (ref < 0 || ip - ref > MaxOffset || read32(src + ref) != sequence)
+				{
+					ip++;
+					continue;
+				}
+
+				size_t matchLen = MinMatch;
+				while (ip + matchLen < matchLimit && src[ref + matchLen] == src[ip + matchLen])
+				{
+					matchLen++;
+				}
+
+				writeSequence(dst, src + anchor, ip - anchor, ip - ref, matchLen);
+				ip += matchLen;
+				anchor = ip;
+			}
+		}
+
+		writeLastLiterals(dst, src + anchor, srcSize - anchor);
+	}
+
+	bool Lz4DecompressBlock(const uint8_t* src, size_t srcSize, size_t dstSize, std::string& dst)
+	{
+		dst.resize(dstSize);
+		size_t ip = 0;
+		size_t op = 0;
+
+		while (ip < srcSize)
+		{
+			const uint8_t token = src[ip++];
+
+			size_t literalLen = token >> 4;
+			if (literalLen == 15 && !readLength(src, srcSize, ip, literalLen))
+				return false;
+			if (literalLen > srcSize - ip || literalLen > dstSize - op)
+				return false;
+			std::memcpy(&dst[op], src + ip, literalLen);
+			ip += literalLen;
+			op += literalLen;
+
+			if (ip == srcSize)
+				break; // the last sequence has no match part
+
+			if (srcSize - ip < 2)
+				return false;
+			const size_t offset = src[ip] | (static_cast<size_t>(src[ip + 1]) << 8);
+			ip += 2;
+			if (offset == 0 || offset > op)
+				return false;
+
+			size_t matchLen = token & 15;
+			if (matchLen == 15 && !readLength(src, srcSize, ip, matchLen))
+				return false;
+			matchLen += MinMatch;
+			if (matchLen > dstSize - op)
+				return false;
+
+			// byte-wise copy because the match may overlap the bytes being written
+			for (size_t i = 0; i < matchLen; i++)
+			{
+				dst[op + i] = dst[op - offset + i];
+			}
+			op += matchLen;
+		}
+
+		return op == dstSize;
+	}
+
+	bool IsCompressedFrame(const void* data, size_t size)
+	{
+		return size >= CompressedFrameHeaderSize && std::memcmp(data, CompressedFrameMagic, sizeof(CompressedFrameMagic)) == 0;
+	}
+
+	bool CompressFrame(const std::string& msg, std::string& frame)
+	{
+		std::string block;
+		Lz4CompressBlock(reinterpret_cast<const uint8_t*>(msg.data()), msg.size(), block);
+		if (block.size() + CompressedFrameHeaderSize >= msg.size())
+			return false;
+
+		const uint32_t size = static_cast<uint32_t>(msg.size());
+		const uint8_t sizeBytes[4] = {
+			static_cast<uint8_t>(size & 0xFF),
+			static_cast<uint8_t>((size >> 8) & 0xFF),
+			static_cast<uint8_t>((size >> 16) & 0xFF),
+			static_cast<uint8_t>((size >> 24) & 0xFF)
+		};
+
+		frame.clear();
+		frame.reserve(CompressedFrameHeaderSize + block.size());
+		frame.append(CompressedFrameMagic, sizeof(CompressedFrameMagic));
+		frame.append(reinterpret_cast<const char*>(sizeBytes), sizeof(sizeBytes));
+		frame.append(block);
+		return true;
+	}
+
+	bool DecompressFrame(const void* data, size_t size, std::string& msg)
+	{
+		if (!IsCompressedFrame(data, size))
+			return false;
+
+		const uint8_t* p = static_cast<const uint8_t*>(data);
+		const size_t uncompressedSize = p[4] | (p[5] << 8) | (p[6] << 16) | (static_cast<size_t>(p[7]) << 24);
+		if (uncompressedSize > MaxDecompressedFrameSize)
+			return false;
+
+		return Lz4DecompressBlock(p + CompressedFrameHeaderSize, size - CompressedFrameHeaderSize, uncompressedSize, msg);
+	}
+}
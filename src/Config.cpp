@@ -122,6 +122,33 @@ namespace xpilot
                 {
                     setLogLevel(jf["LogLevel"]);
                 }
+                if (jf.contains("LogLevels"))
+                {
+                    for (auto& level : jf["LogLevels"].items())
+                    {
+                        setCategoryLogLevel(level.key(), level.value());
+                    }
+                }
+                if (jf.contains("AdaptiveJitterBuffer"))
+                {
+                    setAdaptiveJitterBuffer(jf["AdaptiveJitterBuffer"]);
+                }
+                if (jf.contains("CubicInterpolation"))
+                {
+                    setCubicInterpolation(jf["CubicInterpolation"]);
+                }
+                if (jf.contains("ModelLoadDistance"))
+                {
+                    setModelLoadDistance(jf["ModelLoadDistance"]);
+                }
+                if (jf.contains("MaxLoadedModels"))
+                {
+                    setMaxLoadedModels(jf["MaxLoadedModels"]);
+                }
+                if (jf.contains("ConsoleHistoryLimit"))
+                {
+                    setConsoleHistoryLimit(jf["ConsoleHistoryLimit"]);
+                }
                 if (jf.contains("CSL"))
                 {
                     json cslpackages = jf["CSL"];
@@ -168,6 +195,15 @@ namespace xpilot
         j["MaxLabelDist"] = getMaxLabelDistance();
         j["LabelCutoffVis"] = getLabelCutoffVis();
         j["LogLevel"] = getLogLevel();
+        if (!m_categoryLogLevels.empty())
+        {
+            j["LogLevels"] = m_categoryLogLevels;
+        }
+        j["AdaptiveJitterBuffer"] = getAdaptiveJitterBuffer();
+        j["CubicInterpolation"] = getCubicInterpolation();
+        j["ModelLoadDistance"] = getModelLoadDistance();
+        j["MaxLoadedModels"] = getMaxLoadedModels();
+        j["ConsoleHistoryLimit"] = getConsoleHistoryLimit();
 
         if (!m_cslPackages.empty())
         {
@@ -228,24 +264,24 @@ namespace xpilot
 
             if (CountFilesInPath(path) > 1)
             {
-                LOG_MSG(logDEBUG, "Found CSL Path: %s", path.c_str());
+                LOG_CAT(Csl, logDEBUG, "Found CSL Path: %s", path.c_str());
                 if (!path.empty())
                 {
                     auto err = XPMPLoadCSLPackage(path.c_str());
                     if (*err)
                     {
-                        LOG_MSG(logERROR, "Error loading CSL package (%s): %s", path.c_str(), err);
+                        LOG_CAT(Csl, logERROR, "Error loading CSL package (%s): %s", path.c_str(), err);
                     }
                     else
                     {
-                        LOG_MSG(logDEBUG, "CSL package successfully loaded: %s", path.c_str());
+                        LOG_CAT(Csl, logDEBUG, "CSL package successfully loaded: %s", path.c_str());
                         return true;
                     }
                 }
             }
             else
             {
-                LOG_MSG(logDEBUG, "Skipping CSL path '%s' because it does not exist or the folder is empty.", path.c_str());
+                LOG_CAT(Csl, logDEBUG, "Skipping CSL path '%s' because it does not exist or the folder is empty.", path.c_str());
             }
         }
         return false;
@@ -363,6 +399,62 @@ namespace xpilot
         if (lvl > 5) lvl = 5;
         if (lvl < 0) lvl = 0;
         m_logLevel = lvl;
+        applyLogLevels();
+        return true;
+    }
+
+    bool Config::setCategoryLogLevel(const std::string& category, int lvl)
+    {
+        if (lvl < 0)
+        {
+            m_categoryLogLevels.erase(category);
+        }
+        else
+        {
+            m_categoryLogLevels[category] = (std::min)(lvl, 5);
+        }
+        applyLogLevels();
+        return true;
+    }
+
+    void Config::applyLogLevels()const
+    {
+        // LOG_MSG reads the levels from AsyncLog, which any thread may do while they change
+        for (size_t i = 0; i < LogCategoryCount; i++)
+        {
+            const LogCategory category = static_cast<LogCategory>(i);
+            auto it = m_categoryLogLevels.find(LogCategoryName(category));
+            AsyncLog::Instance().setLevel(category, it != m_categoryLogLevels.end() ? it->second : m_logLevel);
+        }
+    }
+
+    bool Config::setAdaptiveJitterBuffer(bool enabled)
+    {
+        m_adaptiveJitterBuffer = enabled;
+        return true;
+    }
+
+    bool Config::setCubicInterpolation(bool enabled)
+    {
+        m_cubicInterpolation = enabled;
+        return true;
+    }
+
+    bool Config::setModelLoadDistance(int nm)
+    {
+        m_modelLoadDistance = (std::max)(0, nm);
+        return true;
+    }
+
+    bool Config::setMaxLoadedModels(int count)
+    {
+        m_maxLoadedModels = (std::max)(1, count);
+        return true;
+    }
+
+    bool Config::setConsoleHistoryLimit(int messages)
+    {
+        m_consoleHistoryLimit = (std::max)(10, messages);
         return true;
     }
 }
\ No newline at end of file
@@ -0,0 +1,435 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <unordered_set>
+
+#if IBM
+#include <windows.h>
+#endif
+#include <sys/types.h>
+#include <sys/stat.h>
+#if !IBM
+#include <dirent.h>
+#endif
+
+#include "CslIndex.h"
+#include "Utilities.h"
+
+namespace xpilot
+{
+	namespace
+	{
+		constexpr char IndexFileMagic[4] = { 'X', 'P', 'C', 'I' };
+		constexpr uint32_t IndexFileVersion = 4;
+
+		bool iequals(const std::string& a, const char* b)
+		{
+			const size_t n = strlen(b);
+			if (a.size() != n) return false;
+			for (size_t i = 0; i < n; i++)
+			{
+				if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i]))) return false;
+			}
+			return true;
+		}
+
+		std::string joinPath(const std::string& dir, const std::string& name)
+		{
+			if (!dir.empty() && (dir.back() == '/' || dir.back() == '\\'))
+				return dir + name;
+			return dir + "/" + name;
+		}
+
+		// the XPLM directory functions may only be called from the sim thread
+		void listDirectory(const std::string& path, std::vector<std::string>& subdirs, std::string& xsbFile)
+		{
+#if IBM
+			WIN32_FIND_DATAA data;
+			HANDLE h = FindFirstFileA(joinPath(path, "*").c_str(), &data);
+			if (h == INVALID_HANDLE_VALUE)
+				return;
+			do
+			{
+				const std::string name(data.cFileName);
+				if (name == "." || name == "..")
+					continue;
+				if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+					subdirs.push_back(joinPath(path, name));
+				else if (iequals(name, "xsb_aircraft.txt"))
+					xsbFile = joinPath(path, name);
+			} while (FindNextFileA(h, &data));
+			FindClose(h);
+#else
+			DIR* dir = opendir(path.c_str());
+			if (!dir)
+				return;
+			while (struct dirent* entry = readdir(dir))
+			{
+				const std::string name(entry->d_name);
+				if (name == "." || name == "..")
+					continue;
+				const std::string full = joinPath(path, name);
+				struct stat st;
+				if (stat(full.c_str(), &st) != 0)
+					continue;
+				if (S_ISDIR(st.st_mode))
+					subdirs.push_back(full);
+				else if (iequals(name, "xsb_aircraft.txt"))
+					xsbFile = full;
+			}
+			closedir(dir);
+#endif
+		}
+
+		bool fingerprint(const std::string& path, CslFingerprint& fp)
+		{
+#if IBM
+			struct _stat64 st;
+			if (_stat64(path.c_str(), &st) != 0)
+				return false;
+			const bool isDir = (st.st_mode & _S_IFDIR) != 0;
+#else
+			struct stat st;
+			if (stat(path.c_str(), &st) != 0)
+				return false;
+			const bool isDir = S_ISDIR(st.st_mode);
+#endif
+			fp.path = path;
+			fp.mtime = static_cast<int64_t>(st.st_mtime);
+			fp.size = isDir ? 0 : static_cast<int64_t>(st.st_size);
+			return true;
+		}
+
+		void parseXsbAircraft(const std::string& xsbFile, const Doc8643Classes& classes, CslFolderEntry& folder)
+		{
+			std::vector<CslModelEntry>& models = folder.models;
+			std::ifstream in(xsbFile);
+			std::string line;
+			CslModelEntry current;
+			bool inModel = false;
+			std::unordered_set<std::string> names;
+
+			while (std::getline(in, line))
+			{
+				std::istringstream tokens(line);
+				std::string keyword;
+				if (!(tokens >> keyword))
+					continue;
+
+				if (keyword == "EXPORT_NAME" && folder.exportName.empty())
+				{
+					tokens >> folder.exportName;
+				}
+				else if (keyword == "OBJ8_AIRCRAFT")
+				{
+					current = CslModelEntry();
+					// XPMP2 forms the cslId from the rest of the line, without the trailing
+					// blanks (or CR of a file with Windows line endings)
+					std::getline(tokens >> std::ws, current.name);
+					current.name.erase(current.name.find_last_not_of(" \t\r") + 1);
+					names.insert(current.name);
+					inModel = true;
+				}
+				else if (!inModel)
+				{
+					continue;
+				}
+				else if (keyword == "OBJ8" && current.objPath.empty())
+				{
+					std::string group, animate;
+					tokens >> group >> animate >> current.objPath;
+				}
+				else if (keyword == "ICAO" || keyword == "AIRLINE" || keyword == "LIVERY" || keyword == "MATCHES")
+				{
+					// every match line makes the model available under another ICAO/airline/livery
+					CslModelEntry entry = current;
+					tokens >> entry.icao >> entry.airline >> entry.livery;
+					auto it = classes.find(entry.icao);
+					if (it != classes.end())
+					{
+						entry.classification = it->second;
+					}
+					models.push_back(entry);
+				}
+			}
+			folder.modelCount = static_cast<uint32_t>(names.size());
+		}
+
+		void writeU32(std::ostream& out, uint32_t v)
+		{
+			const char b[4] = { char(v & 0xFF), char((v >> 8) & 0xFF), char((v >> 16) & 0xFF), char((v >> 24) & 0xFF) };
+			out.write(b, 4);
+		}
+
+		void writeI64(std::ostream& out, int64_t v)
+		{
+			writeU32(out, static_cast<uint32_t>(static_cast<uint64_t>(v) & 0xFFFFFFFF));
+			writeU32(out, static_cast<uint32_t>(static_cast<uint64_t>(v) >> 32));
+		}
+
+		void writeString(std::ostream& out, const std::string& s)
+		{
+			writeU32(out, static_cast<uint32_t>(s.size()));
+			out.write(s.data(), s.size());
+		}
+
+		class Reader
+		{
+		public:
+			explicit Reader(const std::string& data) : m_data(data) {}
+
+			bool u32(uint32_t& v)
+			{
+				if (m_pos + 4 > m_data.size()) return false;
+				v = 0;
+				for (int i = 3; i >= 0; i--)
+					v = (v << 8) | static_cast<uint8_t>(m_data[m_pos + i]);
+				m_pos += 4;
+				return true;
+			}
+
+			bool i64(int64_t& v)
+			{
+				uint32_t lo, hi;
+				if (!u32(lo) || !u32(hi)) return false;
+				v = static_cast<int64_t>((static_cast<uint64_t>(hi) << 32) | lo);
+				return true;
+			}
+
+			bool str(std::string& s)
+			{
+				uint32_t n;
+				if (!u32(n) || m_pos + n > m_data.size()) return false;
+				s.assign(m_data, m_pos, n);
+				m_pos += n;
+				return true;
+			}
+
+		private:
+			const std::string& m_data;
+			size_t m_pos = sizeof(IndexFileMagic);
+		};
+	}
+
+	size_t CslPackageIndex::modelCount()const
+	{
+		size_t count = 0;
+		for (const CslFolderEntry& folder : folders)
+			count += folder.modelCount;
+		return count;
+	}
+
+	bool CslIndex::load(const std::string& path)
+	{
+		m_packages.clear();
+
+		std::ifstream in(path, std::ios::binary);
+		if (!in)
+			return false;
+
+		const std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+		if (data.size() < sizeof(IndexFileMagic) || data.compare(0, 4, IndexFileMagic, 4) != 0)
+			return false;
+
+		Reader r(data);
+		uint32_t version = 0, packageCount = 0;
+		if (!r.u32(version) || version != IndexFileVersion || !r.u32(packageCount))
+			return false;
+
+		std::vector<CslPackageIndex> packages(packageCount);
+		for (CslPackageIndex& package : packages)
+		{
+			uint32_t fingerprintCount, folderCount;
+			if (!r.str(package.root) || !r.u32(fingerprintCount))
+				return false;
+			package.fingerprints.resize(fingerprintCount);
+			for (CslFingerprint& fp : package.fingerprints)
+			{
+				if (!r.str(fp.path) || !r.i64(fp.mtime) || !r.i64(fp.size))
+					return false;
+			}
+
+			if (!r.u32(folderCount))
+				return false;
+			package.folders.resize(folderCount);
+			for (CslFolderEntry& folder : package.folders)
+			{
+				uint32_t modelCount;
+				if (!r.str(folder.path) || !r.str(folder.exportName) || !r.u32(folder.modelCount) || !r.u32(modelCount))
+					return false;
+				folder.models.resize(modelCount);
+				for (CslModelEntry& m : folder.models)
+				{
+					if (!r.str(m.name) || !r.str(m.icao) || !r.str(m.airline) || !r.str(m.livery)
+						|| !r.str(m.classification) || !r.str(m.objPath))
+						return false;
+				}
+			}
+		}
+
+		m_packages = std::move(packages);
+		return true;
+	}
+
+	bool CslIndex::save(const std::string& path)const
+	{
+		std::ofstream out(path, std::ios::binary | std::ios::trunc);
+		if (!out)
+		{
+			LOG_CAT(Csl, logERROR, "Could not write CSL index to %s", path.c_str());
+			return false;
+		}
+
+		out.write(IndexFileMagic, sizeof(IndexFileMagic));
+		writeU32(out, IndexFileVersion);
+		writeU32(out, static_cast<uint32_t>(m_packages.size()));
+		for (const CslPackageIndex& package : m_packages)
+		{
+			writeString(out, package.root);
+			writeU32(out, static_cast<uint32_t>(package.fingerprints.size()));
+			for (const CslFingerprint& fp : package.fingerprints)
+			{
+				writeString(out, fp.path);
+				writeI64(out, fp.mtime);
+				writeI64(out, fp.size);
+			}
+			writeU32(out, static_cast<uint32_t>(package.folders.size()));
+			for (const CslFolderEntry& folder : package.folders)
+			{
+				writeString(out, folder.path);
+				writeString(out, folder.exportName);
+				writeU32(out, folder.modelCount);
+				writeU32(out, static_cast<uint32_t>(folder.models.size()));
+				for (const CslModelEntry& m : folder.models)
+				{
+					writeString(out, m.name);
+					writeString(out, m.icao);
+					writeString(out, m.airline);
+					writeString(out, m.livery);
+					writeString(out, m.classification);
+					writeString(out, m.objPath);
+				}
+			}
+		}
+		return static_cast<bool>(out);
+	}
+
+	const CslPackageIndex* CslIndex::find(const std::string& root)const
+	{
+		auto it = std::find_if(m_packages.begin(), m_packages.end(), [&root](const CslPackageIndex& p) { return p.root == root; });
+		return it != m_packages.end() ? &*it : nullptr;
+	}
+
+	void CslIndex::put(const CslPackageIndex& package)
+	{
+		auto it = std::find_if(m_packages.begin(), m_packages.end(), [&package](const CslPackageIndex& p) { return p.root == package.root; });
+		if (it != m_packages.end())
+		{
+			*it = package;
+		}
+		else
+		{
+			m_packages.push_back(package);
+		}
+	}
+
+	bool CslIndex::isCurrent(const CslPackageIndex& package)
+	{
+		if (package.fingerprints.empty())
+			return false;
+
+		for (const CslFingerprint& cached : package.fingerprints)
+		{
+			CslFingerprint current;
+			if (!fingerprint(cached.path, current) || current.mtime != cached.mtime || current.size != cached.size)
+				return false;
+		}
+		return true;
+	}
+
+	CslPackageIndex CslIndex::scan(const std::string& root, const Doc8643Classes& classes, const std::atomic<bool>* stopRequested)
+	{
+		CslPackageIndex package;
+		package.root = root;
+
+		// like XPMP2, don't look further down once a folder has an xsb_aircraft.txt
+		std::vector<std::string> pending{ root };
+		while (!pending.empty() && !(stopRequested && *stopRequested))
+		{
+			const std::string dir = pending.back();
+			pending.pop_back();
+
+			CslFingerprint fp;
+			if (fingerprint(dir, fp))
+			{
+				package.fingerprints.push_back(fp);
+			}
+
+			std::vector<std::string> subdirs;
+			std::string xsbFile;
+			listDirectory(dir, subdirs, xsbFile);
+
+			if (!xsbFile.empty())
+			{
+				if (fingerprint(xsbFile, fp))
+				{
+					package.fingerprints.push_back(fp);
+				}
+				CslFolderEntry folder;
+				folder.path = dir;
+				parseXsbAircraft(xsbFile, classes, folder);
+				package.folders.push_back(std::move(folder));
+			}
+			else
+			{
+				pending.insert(pending.end(), subdirs.begin(), subdirs.end());
+			}
+		}
+
+		std::sort(package.folders.begin(), package.folders.end(),
+			[](const CslFolderEntry& a, const CslFolderEntry& b) { return a.path < b.path; });
+		return package;
+	}
+
+	Doc8643Classes CslIndex::loadDoc8643(const std::string& path)
+	{
+		// XPMP2's copy: manufacturer, model, designator, description, WTC, separated by tabs
+		Doc8643Classes classes;
+		std::ifstream in(path);
+		std::string line;
+		while (std::getline(in, line))
+		{
+			std::vector<std::string> fields;
+			std::istringstream ss(line);
+			std::string field;
+			while (std::getline(ss, field, '\t'))
+				fields.push_back(field);
+			if (fields.size() >= 4 && !fields[2].empty())
+			{
+				classes.emplace(fields[2], fields[3]);
+			}
+		}
+		return classes;
+	}
+}
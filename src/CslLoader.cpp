@@ -0,0 +1,237 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include <algorithm>
+
+#include "CslLoader.h"
+#include "ModelMatchCache.h"
+#include "XPMPMultiplayer.h"
+#include "Utilities.h"
+#include "Tracer.h"
+
+namespace xpilot
+{
+	namespace
+	{
+		constexpr unsigned MaxScanThreads = 4;
+	}
+
+	CslLoader::~CslLoader()
+	{
+		stop();
+	}
+
+	void CslLoader::start(const std::vector<std::string>& packages, const std::string& indexPath, const std::string& doc8643Path)
+	{
+		stop();
+
+		m_indexPath = indexPath;
+		m_doc8643Path = doc8643Path;
+		m_doc8643Loaded = false;
+		m_doc8643.clear();
+		if (!packages.empty() && !m_index.load(indexPath))
+		{
+			LOG_CAT(Csl, logDEBUG, "No usable CSL index at %s, all packages will be scanned", indexPath.c_str());
+		}
+
+		// the matches found so far may no longer be what the new set of models gives
+		ModelMatchCache::Instance().clear();
+
+		m_started = true;
+		m_finished = false;
+		m_startTime = std::chrono::steady_clock::now();
+		m_scans.clear();
+		for (const std::string& root : packages)
+		{
+			auto scan = std::make_unique<PackageScan>();
+			scan->root = root;
+			m_scans.push_back(std::move(scan));
+		}
+		m_nextScan = 0;
+		m_commitPackage = 0;
+		m_commitFolder = 0;
+		m_foldersLoaded = 0;
+		m_modelsLoaded = 0;
+		m_commitFrames = 0;
+		m_commitMicros = 0;
+		m_stopRequested = false;
+
+		const unsigned hardwareThreads = (std::max)(1u, std::thread::hardware_concurrency());
+		const size_t threads = (std::min)({ static_cast<size_t>(hardwareThreads), static_cast<size_t>(MaxScanThreads), m_scans.size() });
+		for (size_t i = 0; i < threads; i++)
+		{
+			m_workers.emplace_back(&CslLoader::scanWorker, this);
+		}
+		LOG_CAT(Csl, logMSG, "Scanning %u CSL package(s) on %u thread(s)", (unsigned)m_scans.size(), (unsigned)threads);
+	}
+
+	void CslLoader::stop()
+	{
+		m_stopRequested = true;
+		for (std::thread& t : m_workers)
+		{
+			t.join();
+		}
+		m_workers.clear();
+	}
+
+	void CslLoader::scanWorker()
+	{
+		Tracer::Instance().setThreadName("CSL Scan");
+
+		for (size_t i = m_nextScan++; i < m_scans.size() && !m_stopRequested; i = m_nextScan++)
+		{
+			scanPackage(*m_scans[i]);
+		}
+	}
+
+	void CslLoader::scanPackage(PackageScan& scan)
+	{
+		TraceScope trace("Scan CSL Package");
+		const auto begin = std::chrono::steady_clock::now();
+
+		const CslPackageIndex* cached = m_index.find(scan.root);
+		if (cached && CslIndex::isCurrent(*cached))
+		{
+			scan.index = *cached;
+			scan.fromIndex = true;
+		}
+		else
+		{
+			scan.index = CslIndex::scan(scan.root, doc8643Classes(), &m_stopRequested);
+		}
+
+		const auto end = std::chrono::steady_clock::now();
+		scan.finishedAt = std::chrono::duration_cast<std::chrono::microseconds>(end - m_startTime).count();
+		scan.scanMicros = std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count();
+		scan.done.store(true, std::memory_order_release);
+	}
+
+	const Doc8643Classes& CslLoader::doc8643Classes()
+	{
+		// only needed when something has to be rescanned, which a warm start avoids altogether
+		std::lock_guard<std::mutex> lock(m_doc8643Mutex);
+		if (!m_doc8643Loaded)
+		{
+			m_doc8643 = CslIndex::loadDoc8643(m_doc8643Path);
+			m_doc8643Loaded = true;
+		}
+		return m_doc8643;
+	}
+
+	void CslLoader::saveIndex()
+	{
+		// rebuilt from the configured packages only, so removed ones drop out of the file
+		CslIndex index;
+		for (const auto& scan : m_scans)
+		{
+			index.put(scan->index);
+		}
+		if (index.save(m_indexPath))
+		{
+			LOG_CAT(Csl, logDEBUG, "Saved CSL index to %s", m_indexPath.c_str());
+		}
+	}
+
+	bool CslLoader::commit(std::chrono::microseconds budget)
+	{
+		if (m_finished)
+			return true;
+
+		const auto begin = std::chrono::steady_clock::now();
+		const auto deadline = begin + budget;
+		m_commitFrames++;
+
+		while (m_commitPackage < m_scans.size())
+		{
+			PackageScan& scan = *m_scans[m_commitPackage];
+			if (!scan.done.load(std::memory_order_acquire))
+				break;
+
+			if (m_commitFolder == 0)
+			{
+				LOG_CAT(Csl, logDEBUG, "%s CSL package %s in %.1f ms: %u folder(s), %u model(s)", scan.fromIndex ? "Validated" : "Scanned",
+					scan.root.c_str(), scan.scanMicros / 1000.0, (unsigned)scan.index.folders.size(), (unsigned)scan.index.modelCount());
+			}
+
+			while (m_commitFolder < scan.index.folders.size() && std::chrono::steady_clock::now() < deadline)
+			{
+				const CslFolderEntry& entry = scan.index.folders[m_commitFolder];
+				const std::string& folder = entry.path;
+				TraceScope trace("Load CSL Package");
+				try
+				{
+					const char* err = XPMPLoadCSLPackage(folder.c_str());
+					if (*err)
+					{
+						LOG_CAT(Csl, logERROR, "Error loading CSL package %s: %s", folder.c_str(), err);
+					}
+					else
+					{
+						m_modelsLoaded += entry.modelCount;
+					}
+				}
+				catch (std::exception& e)
+				{
+					LOG_CAT(Csl, logERROR, "Error loading CSL package %s: %s", folder.c_str(), e.what());
+				}
+				m_commitFolder++;
+				m_foldersLoaded++;
+			}
+
+			if (m_commitFolder < scan.index.folders.size())
+				break;
+
+			m_commitPackage++;
+			m_commitFolder = 0;
+		}
+
+		m_commitMicros += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count();
+
+		if (m_commitPackage < m_scans.size())
+			return false;
+
+		stop();
+		m_finished = true;
+
+		long long scanMicros = 0;
+		long long scanWallMicros = 0;
+		size_t fromIndex = 0;
+		std::vector<const CslPackageIndex*> loaded;
+		for (const auto& scan : m_scans)
+		{
+			loaded.push_back(&scan->index);
+			scanMicros += scan->scanMicros;
+			scanWallMicros = (std::max)(scanWallMicros, scan->finishedAt);
+			if (scan->fromIndex) fromIndex++;
+		}
+		if (fromIndex < m_scans.size())
+		{
+			saveIndex();
+		}
+		ModelMatchCache::Instance().prewarm(loaded);
+
+		const long long totalMicros = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_startTime).count();
+		LOG_CAT(Csl, logMSG, "Loaded %u CSL model(s) from %u folder(s) in %.0f ms (%s start, %u of %u package(s) from the index): "
+			"scanning took %.0f ms (%.0f ms of worker time), registering %.0f ms on the sim thread spread over %u frame(s)",
+			(unsigned)m_modelsLoaded, (unsigned)m_foldersLoaded, totalMicros / 1000.0, fromIndex == m_scans.size() ? "warm" : "cold",
+			(unsigned)fromIndex, (unsigned)m_scans.size(), scanWallMicros / 1000.0, scanMicros / 1000.0, m_commitMicros / 1000.0,
+			(unsigned)m_commitFrames);
+		return true;
+	}
+}
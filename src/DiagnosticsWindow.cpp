@@ -0,0 +1,171 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include <algorithm>
+
+#include "DiagnosticsWindow.h"
+#include "Utilities.h"
+#include "LatencyTracker.h"
+
+namespace xpilot
+{
+	namespace
+	{
+		// roughly the last 5 seconds at 60 fps
+		constexpr size_t RollingWindowFrames = 300;
+		constexpr auto StatsUpdateInterval = std::chrono::milliseconds(500);
+
+		long long percentile(std::vector<long long>& values, double p)
+		{
+			const size_t idx = (std::min)(values.size() - 1, static_cast<size_t>(p * values.size()));
+			std::nth_element(values.begin(), values.begin() + idx, values.end());
+			return values[idx];
+		}
+	}
+
+	DiagnosticsWindow::DiagnosticsWindow(WndMode _mode) :
+		XPImgWindow(_mode, WND_STYLE_SOLID, WndRect(0, 480, 460, 0))
+	{
+		SetWindowTitle("xPilot Diagnostics");
+		SetWindowResizingLimits(460, 480, 800, 800);
+		SetVisible(false);
+	}
+
+	void DiagnosticsWindow::updateStats()
+	{
+		Profiler::Instance().snapshot(m_frames, RollingWindowFrames);
+		m_sampleCount = m_frames.size();
+		if (m_frames.empty())
+			return;
+
+		for (size_t stage = 0; stage <= ProfilerStageCount; stage++)
+		{
+			m_scratch.clear();
+			for (const auto& frame : m_frames)
+			{
+				m_scratch.push_back(stage < ProfilerStageCount ? frame.micros[stage] : frame.total());
+			}
+
+			StageStats& stats = m_stats[stage];
+			stats.max = *std::max_element(m_scratch.begin(), m_scratch.end());
+			stats.p99 = percentile(m_scratch, 0.99);
+			stats.p50 = percentile(m_scratch, 0.50);
+		}
+	}
+
+	void DiagnosticsWindow::buildLatencyInterface()
+	{
+		const LatencyTracker& latency = LatencyTracker::Instance();
+
+		ImGui::Spacing();
+		ImGui::Text("Position update latency over the last 10 seconds (milliseconds)");
+		ImGui::Separator();
+
+		ImGui::Columns(4, "latency");
+		ImGui::SetColumnWidth(0, 220);
+		ImGui::SetColumnWidth(1, 70);
+		ImGui::SetColumnWidth(2, 70);
+		ImGui::SetColumnWidth(3, 70);
+
+		ImGui::Text("Hop");
+		ImGui::NextColumn();
+		ImGui::Text("p50");
+		ImGui::NextColumn();
+		ImGui::Text("p99");
+		ImGui::NextColumn();
+		ImGui::Text("count");
+		ImGui::NextColumn();
+
+		ImGui::Separator();
+
+		for (size_t hop = 0; hop < LatencyHopCount; hop++)
+		{
+			const LatencyStats& stats = latency.hopStats(static_cast<LatencyHop>(hop));
+			ImGui::Text("%s", LatencyHopName(static_cast<LatencyHop>(hop)));
+			ImGui::NextColumn();
+			ImGui::Text("%.1f", stats.p50 / 1000.0);
+			ImGui::NextColumn();
+			ImGui::Text("%.1f", stats.p99 / 1000.0);
+			ImGui::NextColumn();
+			ImGui::Text("%llu", (unsigned long long)stats.count);
+			ImGui::NextColumn();
+		}
+
+		ImGui::Columns(1);
+		ImGui::Separator();
+		ImGui::Text("Interpolation delay: %lld ms (%s), underrun rate: %.2f%%", latency.bufferDelay() / 1000,
+			latency.isAdaptive() ? "adaptive" : "fixed", latency.underrunRate() * 100.0f);
+	}
+
+	void DiagnosticsWindow::buildInterface()
+	{
+		ProfileScope profile(ProfilerStage::DiagnosticsWindow);
+
+		const auto now = std::chrono::steady_clock::now();
+		if (now >= m_nextUpdate)
+		{
+			updateStats();
+			m_nextUpdate = now + StatsUpdateInterval;
+		}
+
+		ImGui::PushFont(0);
+
+		ImGui::Text("Rolling statistics over the last %u frames (microseconds)", (unsigned)m_sampleCount);
+		ImGui::Separator();
+
+		ImGui::Columns(4, "diagnostics");
+		ImGui::SetColumnWidth(0, 220);
+		ImGui::SetColumnWidth(1, 70);
+		ImGui::SetColumnWidth(2, 70);
+		ImGui::SetColumnWidth(3, 70);
+
+		ImGui::Text("Stage");
+		ImGui::NextColumn();
+		ImGui::Text("p50");
+		ImGui::NextColumn();
+		ImGui::Text("p99");
+		ImGui::NextColumn();
+		ImGui::Text("max");
+		ImGui::NextColumn();
+
+		ImGui::Separator();
+
+		for (size_t stage = 0; stage <= ProfilerStageCount; stage++)
+		{
+			if (stage == ProfilerStageCount)
+			{
+				ImGui::Separator();
+			}
+
+			const StageStats& stats = m_stats[stage];
+			ImGui::Text("%s", stage < ProfilerStageCount ? ProfilerStageName(static_cast<ProfilerStage>(stage)) : "Total");
+			ImGui::NextColumn();
+			ImGui::Text("%lld", stats.p50);
+			ImGui::NextColumn();
+			ImGui::Text("%lld", stats.p99);
+			ImGui::NextColumn();
+			ImGui::Text("%lld", stats.max);
+			ImGui::NextColumn();
+		}
+
+		ImGui::Columns(1);
+
+		buildLatencyInterface();
+		ImGui::PopFont();
+	}
+}
@@ -0,0 +1,285 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include <algorithm>
+#include <cmath>
+
+#include "Interpolation.h"
+
+namespace xpilot
+{
+	namespace
+	{
+		constexpr double Pi = 3.14159265358979323846;
+
+		// keep noisy or closely spaced snapshots from spinning or launching the aircraft
+		constexpr long long MinRateInterval = 100000;
+		constexpr double MaxTurnRate = 6.0;        // degrees per second, twice a standard rate turn
+		constexpr double MaxVerticalRate = 100.0;  // feet per second
+
+		constexpr double LongSegmentNm = 10.0;
+
+		double clampRate(double rate, double limit)
+		{
+			return rate > limit ? limit : (rate < -limit ? -limit : rate);
+		}
+
+		double Unwrap(double value, double reference)
+		{
+			if (value - reference > 180.0) return value - 360.0;
+			if (value - reference < -180.0) return value + 360.0;
+			return value;
+		}
+
+		double NormalizeLongitude(double longitude)
+		{
+			if (longitude > 180.0) return longitude - 360.0;
+			if (longitude <= -180.0) return longitude + 360.0;
+			return longitude;
+		}
+
+		/**
+		 * Every channel of an interpolated state is a weighted sum of the same four snapshots
+		 * (the segment and its neighbours), so the weights are worked out once per aircraft.
+		 */
+		struct SegmentWeights
+		{
+			double w0, w1, w2, w3;
+
+			double apply(double p0, double p1, double p2, double p3)const
+			{
+				return w0 * p0 + w1 * p1 + w2 * p2 + w3 * p3;
+			}
+		};
+
+		/**
+		 * Cubic Hermite weights for the segment t1..t2 with Catmull-Rom tangents taken from
+		 * the neighbouring snapshots, scaled for their uneven spacing.
+		 */
+		SegmentWeights HermiteWeights(long long t0, long long t1, long long t2, long long t3, double s)
+		{
+			const double s2 = s * s;
+			const double s3 = s2 * s;
+			const double h00 = 2.0 * s3 - 3.0 * s2 + 1.0;
+			const double h10 = s3 - 2.0 * s2 + s;
+			const double h01 = -2.0 * s3 + 3.0 * s2;
+			const double h11 = s3 - s2;
+
+			// tangent at p1 is (p2 - p0) / (t2 - t0), at p2 it is (p3 - p1) / (t3 - t1)
+			const double dt = static_cast<double>(t2 - t1);
+			const double a = dt / static_cast<double>(t2 - t0);
+			const double b = dt / static_cast<double>(t3 - t1);
+
+			return { -h10 * a, h00 - h11 * b, h01 + h10 * a, h11 * b };
+		}
+
+		double SegmentLengthNm(const InterpolatedState& start, const InterpolatedState& end)
+		{
+			const double dLat = end.latitude - start.latitude;
+			const double dLon = Unwrap(end.longitude, start.longitude) - start.longitude;
+			const double cosLat = std::cos(start.latitude * Pi / 180.0);
+			return 60.0 * std::sqrt(dLat * dLat + dLon * dLon * cosLat * cosLat);
+		}
+
+		void GreatCircle(const InterpolatedState& start, const InterpolatedState& end, double pct, double& lat, double& lon)
+		{
+			const double lat1 = start.latitude * Pi / 180.0, lon1 = start.longitude * Pi / 180.0;
+			const double lat2 = end.latitude * Pi / 180.0, lon2 = end.longitude * Pi / 180.0;
+
+			const double x1 = std::cos(lat1) * std::cos(lon1), y1 = std::cos(lat1) * std::sin(lon1), z1 = std::sin(lat1);
+			const double x2 = std::cos(lat2) * std::cos(lon2), y2 = std::cos(lat2) * std::sin(lon2), z2 = std::sin(lat2);
+
+			const double angle = std::acos((std::min)(1.0, x1 * x2 + y1 * y2 + z1 * z2));
+			const double sinAngle = std::sin(angle);
+			const double f1 = std::sin((1.0 - pct) * angle) / sinAngle;
+			const double f2 = std::sin(pct * angle) / sinAngle;
+
+			const double x = f1 * x1 + f2 * x2, y = f1 * y1 + f2 * y2, z = f1 * z1 + f2 * z2;
+			lat = std::atan2(z, std::sqrt(x * x + y * y)) * 180.0 / Pi;
+			lon = std::atan2(y, x) * 180.0 / Pi;
+		}
+
+		InterpolatedState ExtrapolateState(const InterpolatedState& start, const InterpolatedState& end, long long timestamp)
+		{
+			InterpolatedState extrapolated = end;
+			extrapolated.timestamp = timestamp;
+			extrapolated.rendered = false;
+			extrapolated.receivedAt = 0;
+			extrapolated.dequeuedAt = 0;
+
+			const double seconds = ((std::min)(timestamp, end.timestamp + MaxExtrapolationTime) - end.timestamp) / 1000000.0;
+
+			double turnRate = 0.0;
+			double verticalRate = 0.0;
+			const long long interval = end.timestamp - start.timestamp;
+			if (interval >= MinRateInterval)
+			{
+				double headingDelta = end.heading - start.heading;
+				if (std::abs(headingDelta) > 180.0)
+				{
+					headingDelta += (headingDelta > 0.0 ? -360.0 : 360.0);
+				}
+				turnRate = clampRate(headingDelta * 1000000.0 / interval, MaxTurnRate);
+				verticalRate = clampRate((end.altitude - start.altitude) * 1000000.0 / interval, MaxVerticalRate);
+			}
+
+			// fly the average heading of the turn for the whole distance; over a few seconds
+			// that is indistinguishable from integrating the arc
+			const double distanceNm = end.groundSpeed * seconds / 3600.0;
+			const double track = (end.heading + turnRate * seconds / 2.0) * Pi / 180.0;
+			const double cosLat = (std::max)(0.01, std::cos(end.latitude * Pi / 180.0));
+
+			extrapolated.latitude = end.latitude + distanceNm * std::cos(track) / 60.0;
+			extrapolated.longitude = end.longitude + distanceNm * std::sin(track) / 60.0 / cosLat;
+			extrapolated.altitude = end.altitude + verticalRate * seconds;
+			extrapolated.heading = NormalizeHeading(end.heading + turnRate * seconds);
+			return extrapolated;
+		}
+	}
+
+	InterpolatedState InterpolateState(const std::deque<InterpolatedState>& stack, long long timestamp, InterpolationMode mode)
+	{
+		if (stack.size() == 1 || timestamp <= stack.front().timestamp)
+		{
+			return stack.front();
+		}
+
+		// find the segment containing the timestamp, or the last one if we're past the end
+		size_t i = 0;
+		while (i + 2 < stack.size() && stack[i + 1].timestamp < timestamp)
+		{
+			i++;
+		}
+
+		const InterpolatedState& start = stack[i];
+		const InterpolatedState& end = stack[i + 1];
+		if (timestamp > end.timestamp)
+		{
+			return ExtrapolateState(start, end, timestamp);
+		}
+		if (timestamp == end.timestamp)
+		{
+			return end;
+		}
+
+		const double pct = (timestamp - start.timestamp) / (double)(end.timestamp - start.timestamp);
+
+		// the outer snapshots only shape the tangents; at either end of the stack the
+		// segment's own endpoint stands in, which makes that tangent the segment's slope
+		const InterpolatedState& before = i > 0 ? stack[i - 1] : start;
+		const InterpolatedState& after = i + 2 < stack.size() ? stack[i + 2] : end;
+
+		const SegmentWeights w = mode == InterpolationMode::Cubic
+			? HermiteWeights(before.timestamp, start.timestamp, end.timestamp, after.timestamp, pct)
+			: SegmentWeights{ 0.0, 1.0 - pct, pct, 0.0 };
+
+		InterpolatedState interpolated{};
+		interpolated.timestamp = timestamp;
+
+		// headings and longitudes are unwrapped along the chain so the curve never goes the long way round
+		const double heading1 = start.heading;
+		const double heading0 = Unwrap(before.heading, heading1);
+		const double heading2 = Unwrap(end.heading, heading1);
+		const double heading3 = Unwrap(after.heading, heading2);
+		interpolated.heading = NormalizeHeading(w.apply(heading0, heading1, heading2, heading3));
+
+		if (SegmentLengthNm(start, end) > LongSegmentNm)
+		{
+			// after a long gap the flat lat/lon blend visibly leaves the great circle
+			GreatCircle(start, end, pct, interpolated.latitude, interpolated.longitude);
+		}
+		else
+		{
+			const double lon1 = start.longitude;
+			const double lon0 = Unwrap(before.longitude, lon1);
+			const double lon2 = Unwrap(end.longitude, lon1);
+			const double lon3 = Unwrap(after.longitude, lon2);
+			interpolated.latitude = w.apply(before.latitude, start.latitude, end.latitude, after.latitude);
+			interpolated.longitude = NormalizeLongitude(w.apply(lon0, lon1, lon2, lon3));
+		}
+
+		// a cubic altitude would sink below the runway right after touchdown, so it is
+		// kept within the segment's endpoints
+		const double altitude = w.apply(before.altitude, start.altitude, end.altitude, after.altitude);
+		interpolated.altitude = (std::max)((std::min)(start.altitude, end.altitude), (std::min)(altitude, (std::max)(start.altitude, end.altitude)));
+
+		interpolated.pitch = w.apply(before.pitch, start.pitch, end.pitch, after.pitch);
+		interpolated.bank = w.apply(before.bank, start.bank, end.bank, after.bank);
+		interpolated.groundSpeed = start.groundSpeed + ((end.groundSpeed - start.groundSpeed) * pct);
+		return interpolated;
+	}
+
+	InterpolatedState ProjectVelocityState(const VelocityState& state, long long timestamp)
+	{
+		constexpr double MetersPerNm = 1852.0;
+		constexpr double FeetPerMeter = 3.28084;
+		constexpr double KnotsPerMps = 1.94384;
+
+		const InterpolatedState& sample = state.sample;
+		const long long elapsed = (std::max)(0LL, (std::min)(timestamp - sample.timestamp, MaxExtrapolationTime));
+		const double seconds = elapsed / 1000000.0;
+		const double cosLat = (std::max)(0.01, std::cos(sample.latitude * Pi / 180.0));
+
+		InterpolatedState projected = sample;
+		projected.timestamp = timestamp;
+		projected.rendered = false;
+		projected.receivedAt = 0;
+		projected.dequeuedAt = 0;
+		projected.latitude = sample.latitude + state.velocityNorth * seconds / MetersPerNm / 60.0;
+		projected.longitude = NormalizeLongitude(sample.longitude + state.velocityEast * seconds / MetersPerNm / 60.0 / cosLat);
+		projected.altitude = sample.altitude + state.velocityUp * seconds * FeetPerMeter;
+		projected.pitch = sample.pitch + state.pitchRate * seconds;
+		projected.bank = sample.bank + state.bankRate * seconds;
+		projected.heading = NormalizeHeading(sample.heading + state.headingRate * seconds);
+		projected.groundSpeed = std::sqrt(state.velocityNorth * state.velocityNorth + state.velocityEast * state.velocityEast) * KnotsPerMps;
+		return projected;
+	}
+
+	InterpolatedState StateError(const InterpolatedState& drawn, const InterpolatedState& target)
+	{
+		InterpolatedState error{};
+		error.latitude = drawn.latitude - target.latitude;
+		error.longitude = Unwrap(drawn.longitude, target.longitude) - target.longitude;
+		error.altitude = drawn.altitude - target.altitude;
+		error.pitch = drawn.pitch - target.pitch;
+		error.bank = drawn.bank - target.bank;
+		error.heading = Unwrap(drawn.heading, target.heading) - target.heading;
+		return error;
+	}
+
+	InterpolatedState ApplyStateError(const InterpolatedState& state, const InterpolatedState& error, double fraction)
+	{
+		InterpolatedState corrected = state;
+		corrected.latitude += error.latitude * fraction;
+		corrected.longitude = NormalizeLongitude(state.longitude + error.longitude * fraction);
+		corrected.altitude += error.altitude * fraction;
+		corrected.pitch += error.pitch * fraction;
+		corrected.bank += error.bank * fraction;
+		corrected.heading = NormalizeHeading(state.heading + error.heading * fraction);
+		return corrected;
+	}
+
+	void PruneInterpolationStack(std::deque<InterpolatedState>& stack, long long timestamp)
+	{
+		// keep the snapshot behind the current segment (stack[0]) for the cubic tangents
+		while (stack.size() > 3 && stack[2].timestamp <= timestamp)
+		{
+			stack.pop_front();
+		}
+	}
+}
@@ -0,0 +1,207 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include <algorithm>
+#include <cmath>
+
+#include "LatencyTracker.h"
+#include "Utilities.h"
+
+namespace xpilot
+{
+	namespace
+	{
+		constexpr auto PublishInterval = std::chrono::seconds(10);
+
+		// don't resize the buffer on a handful of samples
+		constexpr uint64_t MinGapSamples = 50;
+		constexpr uint32_t MinUpdateSamples = 50;
+
+		// the buffer grows faster than it shrinks; each step moves every aircraft's
+		// timeline by that much, which is only noticeable as a brief change in speed
+		constexpr long long MaxGrowStep = 500000;
+		constexpr long long MaxShrinkStep = 250000;
+
+		constexpr long long MinMargin = 100000;
+		constexpr long long MaxMargin = 2000000;
+	}
+
+	const char* LatencyHopName(LatencyHop hop)
+	{
+		switch (hop)
+		{
+		case LatencyHop::Decode: return "Decode";
+		case LatencyHop::Queue: return "Queue";
+		case LatencyHop::Buffer: return "Jitter Buffer";
+		case LatencyHop::EndToEnd: return "End to End";
+		default: return "";
+		}
+	}
+
+	size_t LatencyHistogram::bucketIndex(long long micros)
+	{
+		if (micros < 4)
+			return static_cast<size_t>((std::max)(micros, 0LL));
+
+		int octave = 2;
+		while (octave < 62 && (micros >> (octave + 1)) != 0)
+			octave++;
+
+		const size_t sub = static_cast<size_t>((micros >> (octave - 2)) & 3);
+		return (std::min)(static_cast<size_t>(octave - 1) * 4 + sub, BucketCount - 1);
+	}
+
+	long long LatencyHistogram::bucketUpperBound(size_t idx)
+	{
+		if (idx < 4)
+			return static_cast<long long>(idx);
+
+		const int octave = static_cast<int>(idx / 4) + 1;
+		const long long sub = static_cast<long long>(idx % 4);
+		return ((5 + sub) << (octave - 2)) - 1;
+	}
+
+	void LatencyHistogram::add(long long micros)
+	{
+		m_buckets[bucketIndex(micros)].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void LatencyHistogram::drain(Buckets& out)
+	{
+		for (size_t i = 0; i < BucketCount; i++)
+		{
+			out[i] = m_buckets[i].exchange(0, std::memory_order_relaxed);
+		}
+	}
+
+	uint64_t LatencyHistogram::count(const Buckets& buckets)
+	{
+		uint64_t total = 0;
+		for (uint32_t n : buckets)
+			total += n;
+		return total;
+	}
+
+	long long LatencyHistogram::percentile(const Buckets& buckets, double p)
+	{
+		const uint64_t total = count(buckets);
+		if (total == 0)
+			return 0;
+
+		const uint64_t rank = (std::max)(static_cast<uint64_t>(std::ceil(p * total)), static_cast<uint64_t>(1));
+		uint64_t seen = 0;
+		for (size_t i = 0; i < BucketCount; i++)
+		{
+			seen += buckets[i];
+			if (seen >= rank)
+				return bucketUpperBound(i);
+		}
+		return bucketUpperBound(BucketCount - 1);
+	}
+
+	LatencyTracker& LatencyTracker::Instance()
+	{
+		static auto&& tracker = LatencyTracker();
+		return tracker;
+	}
+
+	void LatencyTracker::setAdaptive(bool adaptive)
+	{
+		if (adaptive == m_adaptive)
+			return;
+
+		m_adaptive = adaptive;
+		if (!m_adaptive)
+		{
+			m_bufferDelay = FixedBufferDelay;
+		}
+		LOG_CAT(Interpolation, logMSG, "Adaptive interpolation delay %s", m_adaptive ? "enabled" : "disabled");
+	}
+
+	void LatencyTracker::update()
+	{
+		const auto now = std::chrono::steady_clock::now();
+		if (now < m_nextPublish)
+			return;
+		publish();
+	}
+
+	void LatencyTracker::publish()
+	{
+		m_nextPublish = std::chrono::steady_clock::now() + PublishInterval;
+
+		LatencyHistogram::Buckets buckets;
+		for (size_t i = 0; i < LatencyHopCount; i++)
+		{
+			m_hops[i].drain(buckets);
+			m_hopStats[i].p50 = LatencyHistogram::percentile(buckets, 0.50);
+			m_hopStats[i].p99 = LatencyHistogram::percentile(buckets, 0.99);
+			m_hopStats[i].count = LatencyHistogram::count(buckets);
+		}
+
+		// older gaps fade out by half every interval, so the buffer follows changes in
+		// the network (or in how often the server sends updates) within a minute or so
+		m_gaps.drain(buckets);
+		for (size_t i = 0; i < LatencyHistogram::BucketCount; i++)
+		{
+			m_gapHistory[i] = m_gapHistory[i] / 2 + buckets[i];
+		}
+
+		const uint32_t updates = m_updates.exchange(0, std::memory_order_relaxed);
+		const uint32_t underruns = m_underruns.exchange(0, std::memory_order_relaxed);
+		m_underrunRate = updates > 0 ? static_cast<float>(underruns) / updates : 0.0f;
+
+		if (m_adaptive && updates >= MinUpdateSamples)
+		{
+			// the margin covers what the gap distribution can't see (queueing, frame
+			// timing); widen it while we miss the target and give it back slowly
+			if (m_underrunRate > TargetUnderrunRate)
+			{
+				m_margin = (std::min)(m_margin + 100000, MaxMargin);
+			}
+			else if (m_underrunRate < TargetUnderrunRate / 2)
+			{
+				m_margin = (std::max)(m_margin - 50000, MinMargin);
+			}
+		}
+
+		if (m_adaptive)
+		{
+			adjustBufferDelay();
+		}
+	}
+
+	void LatencyTracker::adjustBufferDelay()
+	{
+		if (LatencyHistogram::count(m_gapHistory) < MinGapSamples)
+			return;
+
+		// an underrun happens whenever the next update takes longer to arrive than the
+		// buffer delay, so cover all but TargetUnderrunRate of the inter-arrival gaps
+		long long target = LatencyHistogram::percentile(m_gapHistory, 1.0 - TargetUnderrunRate) + m_margin;
+		target = (std::max)(MinBufferDelay, (std::min)(target, FixedBufferDelay));
+
+		const long long step = (std::max)(-MaxShrinkStep, (std::min)(target - m_bufferDelay, MaxGrowStep));
+		if (step != 0)
+		{
+			m_bufferDelay += step;
+			LOG_CAT(Interpolation, logDEBUG, "Interpolation delay is now %lld ms (target %lld ms, underrun rate %.2f%%)",
+				m_bufferDelay / 1000, target / 1000, m_underrunRate * 100.0f);
+		}
+	}
+}
@@ -0,0 +1,75 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include "ModelMatchCache.h"
+#include "Utilities.h"
+
+namespace xpilot
+{
+	ModelMatchCache& ModelMatchCache::Instance()
+	{
+		static auto&& cache = ModelMatchCache();
+		return cache;
+	}
+
+	std::string ModelMatchCache::key(const std::string& typeIcao, const std::string& airlineIcao, const std::string& livery)
+	{
+		return typeIcao + '\n' + airlineIcao + '\n' + livery;
+	}
+
+	bool ModelMatchCache::find(const std::string& typeIcao, const std::string& airlineIcao, const std::string& livery, std::string& modelId)const
+	{
+		auto it = m_models.find(key(typeIcao, airlineIcao, livery));
+		if (it == m_models.end())
+			return false;
+		modelId = it->second;
+		return true;
+	}
+
+	void ModelMatchCache::store(const std::string& typeIcao, const std::string& airlineIcao, const std::string& livery, const std::string& modelId)
+	{
+		if (modelId.empty()) return;
+		m_models[key(typeIcao, airlineIcao, livery)] = modelId;
+	}
+
+	void ModelMatchCache::clear()
+	{
+		m_models.clear();
+	}
+
+	void ModelMatchCache::prewarm(const std::vector<const CslPackageIndex*>& packages)
+	{
+		clear();
+		for (const CslPackageIndex* package : packages)
+		{
+			for (const CslFolderEntry& folder : package->folders)
+			{
+				if (folder.exportName.empty()) continue;
+				for (const CslModelEntry& model : folder.models)
+				{
+					if (model.icao.empty() || model.name.empty()) continue;
+					const std::string modelId = folder.exportName + "/" + model.name;
+					m_models.emplace(key(model.icao, model.airline, model.livery), modelId);
+					// traffic rarely comes with a livery, so that's what most lookups ask for
+					m_models.emplace(key(model.icao, model.airline, ""), modelId);
+				}
+			}
+		}
+		LOG_CAT(Csl, logDEBUG, "Model match cache prewarmed with %u combination(s)", (unsigned)m_models.size());
+	}
+}
@@ -0,0 +1,149 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include <algorithm>
+
+#include "ModelResidency.h"
+#include "ModelMatchCache.h"
+#include "AircraftManager.h"
+#include "Config.h"
+#include "Utilities.h"
+
+namespace xpilot
+{
+	void ModelResidency::loadModel(NetworkAircraft* plane, const std::string& typeIcao, const std::string& airlineIcao, const std::string& livery)
+	{
+		plane->modelDeferred = false;
+
+		std::string modelId;
+		if (ModelMatchCache::Instance().find(typeIcao, airlineIcao, livery, modelId) && plane->AssignModel(modelId))
+		{
+			// AssignModel doesn't touch the identification ChangeModel would have updated
+			plane->acIcaoType = typeIcao;
+			plane->acIcaoAirline = airlineIcao;
+			plane->acLivery = livery;
+			return;
+		}
+
+		plane->ChangeModel(typeIcao, airlineIcao, livery);
+		ModelMatchCache::Instance().store(typeIcao, airlineIcao, livery, plane->GetModelInfo().cslId);
+	}
+
+	void ModelResidency::showPlaceholder(NetworkAircraft* plane)
+	{
+		// matched by type only, but the aircraft keeps its airline and livery for labels
+		// and for when it gets its real model
+		const std::string airlineIcao = plane->acIcaoAirline;
+		const std::string livery = plane->acLivery;
+		loadModel(plane, plane->acIcaoType, "", "");
+		plane->acIcaoAirline = airlineIcao;
+		plane->acLivery = livery;
+		plane->modelDeferred = true;
+	}
+
+	void ModelResidency::promote(NetworkAircraft* plane)
+	{
+		if (!plane->requestedModel.empty() && plane->AssignModel(plane->requestedModel))
+		{
+			plane->modelDeferred = false;
+			return;
+		}
+		loadModel(plane, plane->acIcaoType, plane->acIcaoAirline, plane->acLivery);
+	}
+
+	void ModelResidency::update()
+	{
+		m_frame++;
+
+		// XPMP2 reports the camera distance in meters
+		const double loadDistance = Config::Instance().getModelLoadDistance() * 1852.0;
+		const size_t maxModels = static_cast<size_t>((std::max)(1, Config::Instance().getMaxLoadedModels()));
+
+		for (auto& kv : m_models)
+		{
+			kv.second.planes = 0;
+		}
+
+		m_pending.clear();
+		for (auto& kv : mapPlanes)
+		{
+			NetworkAircraft* plane = kv.second.get();
+			if (!plane) continue;
+
+			const float distance = plane->GetCameraDist();
+			if (plane->modelDeferred)
+			{
+				// nothing is deferred anymore once the load distance is switched off
+				if (loadDistance <= 0.0 || (plane->renderCount > 0 && distance <= loadDistance))
+				{
+					m_pending.emplace_back(distance, plane);
+				}
+				continue;
+			}
+
+			ModelUse& use = m_models[plane->GetModelInfo().cslId];
+			use.planes++;
+			if (loadDistance <= 0.0 || distance <= loadDistance * UnloadHysteresis)
+			{
+				use.lastNeeded = m_frame;
+			}
+		}
+
+		// the models XPMP2 is about to unload anyway
+		for (auto it = m_models.begin(); it != m_models.end();)
+		{
+			it = it->second.planes == 0 ? m_models.erase(it) : std::next(it);
+		}
+
+		const size_t loads = (std::min)(MaxLoadsPerFrame, m_pending.size());
+		std::partial_sort(m_pending.begin(), m_pending.begin() + loads, m_pending.end(),
+			[](const std::pair<float, NetworkAircraft*>& a, const std::pair<float, NetworkAircraft*>& b) { return a.first < b.first; });
+		for (size_t i = 0; i < loads; i++)
+		{
+			NetworkAircraft* plane = m_pending[i].second;
+			promote(plane);
+			ModelUse& use = m_models[plane->GetModelInfo().cslId];
+			use.planes++;
+			use.lastNeeded = m_frame;
+		}
+
+		if (loadDistance <= 0.0)
+			return;
+
+		// aircraft within range always get their livery, so this may stay over the limit
+		while (m_models.size() > maxModels)
+		{
+			auto lru = std::min_element(m_models.begin(), m_models.end(),
+				[](const std::pair<const std::string, ModelUse>& a, const std::pair<const std::string, ModelUse>& b) { return a.second.lastNeeded < b.second.lastNeeded; });
+			if (lru->second.lastNeeded == m_frame)
+				break;
+
+			const std::string modelId = lru->first;
+			m_models.erase(lru);
+			for (auto& kv : mapPlanes)
+			{
+				NetworkAircraft* plane = kv.second.get();
+				if (plane && !plane->modelDeferred && plane->GetModelInfo().cslId == modelId)
+				{
+					showPlaceholder(plane);
+				}
+			}
+			LOG_CAT(Csl, logDEBUG, "Unloaded CSL model %s, %u model(s) loaded", modelId.c_str(), (unsigned)m_models.size());
+		}
+	}
+}
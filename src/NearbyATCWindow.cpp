@@ -21,6 +21,7 @@
 #include "XPImgWindow.h"
 #include "NearbyATCWindow.h"
 #include "XPilot.h"
+#include "Profiler.h"
 
 namespace xpilot {
 
@@ -57,6 +58,8 @@ namespace xpilot {
 
 	void NearbyATCWindow::buildInterface() {
 
+		ProfileScope profile(ProfilerStage::NearbyAtcWindow);
+
 		ImGui::PushFont(0);
 
 		ImGui::Columns(3, "whosonline");
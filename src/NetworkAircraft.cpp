@@ -16,33 +16,50 @@
  * along with this program. If not, see http://www.gnu.org/licenses/.
 */
 
+#include <cmath>
+
 #include "NetworkAircraft.h"
 #include "Utilities.h"
 #include "Config.h"
+#include "Profiler.h"
 
 namespace xpilot
 {
     NetworkAircraft::NetworkAircraft(const std::string& _icaoType, const std::string& _icaoAirline, const std::string& _livery,
         XPMPPlaneID _modeS_id = 0, const std::string& _modelName = "") :
         XPMP2::Aircraft(_icaoType, _icaoAirline, _livery, _modeS_id, _modelName),
-        enginesRunning(false),
-        gearDown(false),
         onGround(false),
-        renderCount(0),
+        gearDown(false),
+        enginesRunning(false),
         reverseThrust(false),
-        spoilersDeployed(false),
-        targetFlapPosition(0.0f),
+        groundSpeed(0.0),
+        terrainAltitude(0.0),
         targetGearPosition(0.0f),
+        targetFlapPosition(0.0f),
         targetSpoilerPosition(0.0f),
         targetReversersPosition(0.0f),
-        terrainAltitude(0.0),
-        groundSpeed(0.0)
+        spoilersDeployed(false),
+        renderCount(0),
+        interpolationUnderrun(false),
+        lastReceivedAt(0),
+        lastSourceTimestamp(0),
+        fastPositionActive(false),
+        fastPosition{},
+        fastPositionError{},
+        fastPositionErrorAt(0),
+        hasGroundProbe(false),
+        groundProbeLatitude(0.0),
+        groundProbeLongitude(0.0),
+        groundProbeElevation(0.0),
+        modelDeferred(false)
     {
 
     }
 
     void NetworkAircraft::UpdatePosition(float, int)
     {
+        ProfileScope profile(ProfilerStage::UpdatePosition);
+
         label = callsign;
         if (callsign.length() > 7)
         {
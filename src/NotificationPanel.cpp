@@ -16,22 +16,15 @@
  * along with this program. If not, see http://www.gnu.org/licenses/.
 */
 
+#include <cmath>
+
 #include "NotificationPanel.h"
 #include "Utilities.h"
 #include "Config.h"
+#include "Profiler.h"
 
 namespace xpilot
 {
-    struct NotificationTy
-    {
-        std::string message;
-        float red;
-        float green;
-        float blue;
-    };
-
-    static std::list<NotificationTy> NotificationHistory;
-
     NotificationPanel::NotificationPanel(int left, int top, int right, int bottom) :
         m_scrollToBottom(false),
         m_alwaysVisible(false),
@@ -58,14 +51,34 @@ namespace xpilot
 
     void NotificationPanel::buildInterface()
     {
+        ProfileScope profile(ProfilerStage::NotificationPanelWindow);
+
         ImGuiStyle& style = ImGui::GetStyle();
         style.WindowBorderSize = 0.0f;
 
-        for (auto& e : NotificationHistory)
+        // walk back from the newest message until the panel is full, then draw those in order
+        const float width = ImGui::GetContentRegionAvail().x;
+        const float spacing = style.ItemSpacing.y;
+        const float panelHeight = ImGui::GetWindowHeight();
+        size_t visible = 0;
+        float used = 0.0f;
+        while (visible < m_notificationCount && used < panelHeight)
         {
-            const ImVec4& color = ImVec4(e.red, e.green, e.blue, 1.0f);
-            ImGui::PushStyleColor(ImGuiCol_Text, color);
-            ImGui::TextWrapped(e.message.c_str());
+            NotificationTy& e = m_notifications[(m_newest + MaxNotifications - visible) % MaxNotifications];
+            if (std::fabs(e.wrapWidth - width) >= 1.0f)
+            {
+                e.height = ImGui::CalcTextSize(e.message.c_str(), nullptr, false, width).y;
+                e.wrapWidth = width;
+            }
+            used += e.height + spacing;
+            visible++;
+        }
+
+        for (size_t i = visible; i > 0; i--)
+        {
+            const NotificationTy& e = m_notifications[(m_newest + MaxNotifications - (i - 1)) % MaxNotifications];
+            ImGui::PushStyleColor(ImGuiCol_Text, e.color);
+            ImGui::TextWrapped("%s", e.message.c_str());
             ImGui::PopStyleColor();
         }
         if (m_scrollToBottom)
@@ -87,6 +100,7 @@ namespace xpilot
 
     float NotificationPanel::onFlightLoop(float, float, int, void* refcon)
     {
+        ProfileScope profile(ProfilerStage::NotificationPanel);
         auto* panel = reinterpret_cast<NotificationPanel*>(refcon);
 
         if (panel->GetVisible())
@@ -107,12 +121,13 @@ namespace xpilot
     {
         if (!message.empty())
         {
-            NotificationTy notification;
+            m_newest = (m_newest + 1) % MaxNotifications;
+            m_notificationCount = (std::min)(m_notificationCount + 1, MaxNotifications);
+
+            NotificationTy& notification = m_notifications[m_newest];
             notification.message = string_format("[%s] %s", UtcTimestamp().c_str(), message.c_str());
-            notification.red = red / 255;
-            notification.green = green / 255;
-            notification.blue = blue / 255;
-            NotificationHistory.push_back(notification);
+            notification.color = ImVec4(red / 255, green / 255, blue / 255, 1.0f);
+            notification.wrapWidth = -1.0f;
             m_scrollToBottom = true;
 
             if (Config::Instance().getShowNotificationBar())
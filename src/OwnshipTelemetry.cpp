@@ -0,0 +1,156 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include <cstring>
+#include <chrono>
+
+#include "OwnshipTelemetry.h"
+#include "ZmqReactor.h"
+#include "Utilities.h"
+
+namespace xpilot
+{
+	OwnshipTelemetry::OwnshipTelemetry(ZmqReactor* reactor) :
+		m_latitude("sim/flightmodel/position/latitude", ReadOnly),
+		m_longitude("sim/flightmodel/position/longitude", ReadOnly),
+		m_elevation("sim/flightmodel/position/elevation", ReadOnly),
+		m_agl("sim/flightmodel/position/y_agl", ReadOnly),
+		m_pitch("sim/flightmodel/position/theta", ReadOnly),
+		m_bank("sim/flightmodel/position/phi", ReadOnly),
+		m_heading("sim/flightmodel/position/psi", ReadOnly),
+		m_groundSpeed("sim/flightmodel/position/groundspeed", ReadOnly),
+		m_indicatedAirspeed("sim/flightmodel/position/indicated_airspeed", ReadOnly),
+		m_verticalSpeed("sim/flightmodel/position/vh_ind_fpm", ReadOnly),
+		m_velocityX("sim/flightmodel/position/local_vx", ReadOnly),
+		m_velocityY("sim/flightmodel/position/local_vy", ReadOnly),
+		m_velocityZ("sim/flightmodel/position/local_vz", ReadOnly),
+		m_rollRate("sim/flightmodel/position/P", ReadOnly),
+		m_pitchRate("sim/flightmodel/position/Q", ReadOnly),
+		m_yawRate("sim/flightmodel/position/R", ReadOnly),
+		m_flapRatio("sim/cockpit2/controls/flap_ratio", ReadOnly),
+		m_speedbrakeRatio("sim/cockpit2/controls/speedbrake_ratio", ReadOnly),
+		m_gearDown("sim/cockpit2/controls/gear_handle_down", ReadOnly),
+		m_onGround("sim/flightmodel/failures/onground_any", ReadOnly),
+		m_com1Frequency("sim/cockpit2/radios/actuators/com1_frequency_hz_833", ReadOnly),
+		m_com2Frequency("sim/cockpit2/radios/actuators/com2_frequency_hz_833", ReadOnly),
+		m_transponderCode("sim/cockpit/radios/transponder_code", ReadOnly),
+		m_transponderMode("sim/cockpit/radios/transponder_mode", ReadOnly),
+		m_reactor(reactor),
+		m_rateHz(0.0f),
+		m_sequence(0)
+	{
+		XPLMCreateFlightLoop_t flightLoopParams = {
+			sizeof(flightLoopParams),
+			xplm_FlightLoop_Phase_AfterFlightModel,
+			flightLoopCallback,
+			reinterpret_cast<void*>(this)
+		};
+		m_flightLoopId = XPLMCreateFlightLoop(&flightLoopParams);
+	}
+
+	OwnshipTelemetry::~OwnshipTelemetry()
+	{
+		if (m_flightLoopId)
+		{
+			XPLMDestroyFlightLoop(m_flightLoopId);
+			m_flightLoopId = nullptr;
+		}
+	}
+
+	void OwnshipTelemetry::setRate(float hz)
+	{
+		m_rateHz = (std::max)(0.0f, (std::min)(hz, MaxRateHz));
+		if (m_rateHz > 0.0f)
+		{
+			XPLMScheduleFlightLoop(m_flightLoopId, 1.0f / m_rateHz, true);
+			LOG_CAT(Network, logINFO, "Own-ship telemetry enabled at %.1f Hz", m_rateHz);
+		}
+		else
+		{
+			XPLMScheduleFlightLoop(m_flightLoopId, 0, false);
+			LOG_CAT(Network, logINFO, "Own-ship telemetry disabled");
+		}
+	}
+
+	float OwnshipTelemetry::flightLoopCallback(float, float, int, void* ref)
+	{
+		auto* telemetry = static_cast<OwnshipTelemetry*>(ref);
+		if (!telemetry || telemetry->m_rateHz <= 0.0f)
+			return 0;
+
+		telemetry->sample();
+		return 1.0f / telemetry->m_rateHz;
+	}
+
+	void OwnshipTelemetry::sample()
+	{
+		OwnshipTelemetrySample s{};
+		s.sequence = m_sequence++;
+		s.timestamp = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+		s.latitude = m_latitude;
+		s.longitude = m_longitude;
+		s.altitudeMsl = m_elevation;
+		s.altitudeAgl = m_agl;
+		s.pitch = m_pitch;
+		s.bank = m_bank;
+		s.heading = m_heading;
+		s.groundSpeed = m_groundSpeed;
+		s.indicatedAirspeed = m_indicatedAirspeed;
+		s.verticalSpeed = m_verticalSpeed;
+		s.velocityX = m_velocityX;
+		s.velocityY = m_velocityY;
+		s.velocityZ = m_velocityZ;
+		s.rollRate = m_rollRate;
+		s.pitchRate = m_pitchRate;
+		s.yawRate = m_yawRate;
+		s.flapRatio = m_flapRatio;
+		s.speedbrakeRatio = m_speedbrakeRatio;
+		s.gearDown = m_gearDown != 0;
+		s.onGround = m_onGround != 0;
+		s.com1Frequency = m_com1Frequency;
+		s.com2Frequency = m_com2Frequency;
+		s.transponderCode = m_transponderCode;
+		s.transponderMode = m_transponderMode;
+
+		if (!m_queue.push(s))
+		{
+			// the socket thread is behind; the producer can't pop, so this sample is dropped
+			// rather than the oldest one and the client sees the gap in the sequence numbers
+			m_dropped++;
+			return;
+		}
+		m_reactor->wake();
+	}
+
+	bool OwnshipTelemetry::popFrame(std::string& frame)
+	{
+		OwnshipTelemetrySample s;
+		if (!m_queue.pop(s))
+			return false;
+
+		const uint16_t version = TelemetryFrameVersion;
+		const uint16_t size = sizeof(OwnshipTelemetrySample);
+
+		frame.resize(8 + sizeof(OwnshipTelemetrySample));
+		std::memcpy(&frame[0], TelemetryFrameMagic, 4);
+		std::memcpy(&frame[4], &version, sizeof(version));
+		std::memcpy(&frame[6], &size, sizeof(size));
+		std::memcpy(&frame[8], &s, sizeof(OwnshipTelemetrySample));
+		return true;
+	}
+}
@@ -0,0 +1,138 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include "PerformanceMonitor.h"
+#include "ZmqReactor.h"
+#include "TerrainProbe.h"
+#include "AircraftManager.h"
+#include "LatencyTracker.h"
+
+namespace xpilot
+{
+	namespace
+	{
+		constexpr auto RateUpdateInterval = std::chrono::seconds(1);
+
+		// camera distance bands, in meters
+		constexpr float NearBand = 5556.0f;     // 3 nm
+		constexpr float MediumBand = 18520.0f;  // 10 nm
+		constexpr float FarBand = 55560.0f;     // 30 nm
+	}
+
+	PerformanceMonitor::PerformanceMonitor(const ZmqReactor* reactor) :
+		m_reactor(reactor),
+		m_messagesInPerSecond("xpilot/perf/messages_in_per_sec", ReadOnly),
+		m_bytesInPerSecond("xpilot/perf/bytes_in_per_sec", ReadOnly),
+		m_messagesOutPerSecond("xpilot/perf/messages_out_per_sec", ReadOnly),
+		m_queueDepth("xpilot/perf/callback_queue_depth", ReadOnly),
+		m_drainTime("xpilot/perf/callback_drain_us", ReadOnly),
+		m_interpolationTime("xpilot/perf/interpolation_us", ReadOnly),
+		m_terrainProbesPerFrame("xpilot/perf/terrain_probes_per_frame", ReadOnly),
+		m_aircraftNear("xpilot/perf/aircraft_within_3nm", ReadOnly),
+		m_aircraftMedium("xpilot/perf/aircraft_within_10nm", ReadOnly),
+		m_aircraftFar("xpilot/perf/aircraft_within_30nm", ReadOnly),
+		m_aircraftDistant("xpilot/perf/aircraft_beyond_30nm", ReadOnly),
+		m_latencyP50("xpilot/perf/latency_p50_ms", ReadOnly),
+		m_latencyP99("xpilot/perf/latency_p99_ms", ReadOnly),
+		m_interpolationDelay("xpilot/perf/interpolation_delay_ms", ReadOnly),
+		m_underrunRate("xpilot/perf/interpolation_underrun_rate", ReadOnly),
+		m_lastRateUpdate(std::chrono::steady_clock::now())
+	{
+	}
+
+	void PerformanceMonitor::onFrame(size_t queueDepth, long long drainMicros, long long interpolationMicros)
+	{
+		m_queueDepth = static_cast<int>(queueDepth);
+		m_drainTime = static_cast<float>(drainMicros);
+		m_interpolationTime = static_cast<float>(interpolationMicros);
+
+		const uint64_t probes = TerrainProbe::probeCount();
+		m_terrainProbesPerFrame = static_cast<int>(probes - m_lastTerrainProbes);
+		m_lastTerrainProbes = probes;
+
+		const auto now = std::chrono::steady_clock::now();
+		if (now - m_lastRateUpdate >= RateUpdateInterval)
+		{
+			updateRates(std::chrono::duration<double>(now - m_lastRateUpdate).count());
+			updateAircraftBands();
+			updateLatency();
+			m_lastRateUpdate = now;
+		}
+	}
+
+	void PerformanceMonitor::updateRates(double seconds)
+	{
+		const ZmqReactor::Stats& stats = m_reactor->stats();
+		const uint64_t messagesIn = stats.messagesIn;
+		const uint64_t bytesIn = stats.bytesIn;
+		const uint64_t messagesOut = stats.messagesOut;
+
+		// the counters start over when the server is restarted
+		auto rate = [seconds](uint64_t current, uint64_t previous)
+		{
+			return current >= previous ? static_cast<float>((current - previous) / seconds) : 0.0f;
+		};
+
+		m_messagesInPerSecond = rate(messagesIn, m_lastMessagesIn);
+		m_bytesInPerSecond = rate(bytesIn, m_lastBytesIn);
+		m_messagesOutPerSecond = rate(messagesOut, m_lastMessagesOut);
+
+		m_lastMessagesIn = messagesIn;
+		m_lastBytesIn = bytesIn;
+		m_lastMessagesOut = messagesOut;
+	}
+
+	void PerformanceMonitor::updateAircraftBands()
+	{
+		int nearCount = 0, mediumCount = 0, farCount = 0, distantCount = 0;
+		for (const auto& kv : mapPlanes)
+		{
+			const NetworkAircraft* plane = kv.second.get();
+			if (!plane) continue;
+
+			const float dist = plane->GetCameraDist();
+			if (dist < NearBand) nearCount++;
+			else if (dist < MediumBand) mediumCount++;
+			else if (dist < FarBand) farCount++;
+			else distantCount++;
+		}
+
+		m_aircraftNear = nearCount;
+		m_aircraftMedium = mediumCount;
+		m_aircraftFar = farCount;
+		m_aircraftDistant = distantCount;
+	}
+
+	void PerformanceMonitor::updateLatency()
+	{
+		const LatencyTracker& latency = LatencyTracker::Instance();
+
+		std::vector<float> p50(LatencyHopCount), p99(LatencyHopCount);
+		for (size_t i = 0; i < LatencyHopCount; i++)
+		{
+			const LatencyStats& stats = latency.hopStats(static_cast<LatencyHop>(i));
+			p50[i] = stats.p50 / 1000.0f;
+			p99[i] = stats.p99 / 1000.0f;
+		}
+		m_latencyP50 = p50;
+		m_latencyP99 = p99;
+
+		m_interpolationDelay = latency.bufferDelay() / 1000.0f;
+		m_underrunRate = latency.underrunRate();
+	}
+}
@@ -98,6 +98,7 @@ PLUGIN_API void XPluginDisable(void)
     catch (...)
     {
     }
+    xpilot::AsyncLog::Instance().flushAll();
 }
 
 PLUGIN_API void XPluginStop(void)
@@ -114,6 +115,13 @@ PLUGIN_API void XPluginStop(void)
         XPLMUnregisterCommandHandler(ContactAtcCommand, ContactAtcCommandHandler, 0, 0);
         XPLMUnregisterCommandHandler(ToggleDefaultAtisCommand, ToggleDefaultAtisCommandHandler, 0, 0);
         XPLMUnregisterCommandHandler(ToggleTcasCommand, ToggleTcasCommandHandler, 0, 0);
+        XPLMUnregisterCommandHandler(ToggleDiagnosticsWindowCommand, ToggleDiagnosticsWindowCommandHandler, 0, 0);
+        XPLMUnregisterCommandHandler(ToggleTracingCommand, ToggleTracingCommandHandler, 0, 0);
+        XPLMUnregisterCommandHandler(SaveTraceCommand, SaveTraceCommandHandler, 0, 0);
+        XPLMUnregisterCommandHandler(ToggleSessionRecordingCommand, ToggleSessionRecordingCommandHandler, 0, 0);
+        XPLMUnregisterCommandHandler(ReplaySessionCommand, ReplaySessionCommandHandler, 0, 0);
+        XPLMUnregisterCommandHandler(ReplaySessionFastCommand, ReplaySessionCommandHandler, 0, 0);
+        XPLMUnregisterCommandHandler(ToggleTrafficBenchmarkCommand, ToggleTrafficBenchmarkCommandHandler, 0, 0);
     }
     catch (const std::exception& e)
     {
@@ -122,6 +130,7 @@ PLUGIN_API void XPluginStop(void)
     catch (...)
     {
     }
+    xpilot::AsyncLog::Instance().flushAll();
 }
 
 PLUGIN_API void XPluginReceiveMessage(XPLMPluginID from, int msg, void* inParam)
@@ -224,6 +233,61 @@ int ToggleAircraftLabelsCommandHandler(XPLMCommandRef inCommand, XPLMCommandPhas
     return 0;
 }
 
+int ToggleDiagnosticsWindowCommandHandler(XPLMCommandRef inCommand, XPLMCommandPhase inPhase, void* inRefcon)
+{
+    if (inPhase == xplm_CommandEnd)
+    {
+        environment->toggleDiagnosticsWindow();
+    }
+    return 0;
+}
+
+int ToggleTracingCommandHandler(XPLMCommandRef inCommand, XPLMCommandPhase inPhase, void* inRefcon)
+{
+    if (inPhase == xplm_CommandEnd)
+    {
+        environment->toggleTracing();
+    }
+    return 0;
+}
+
+int SaveTraceCommandHandler(XPLMCommandRef inCommand, XPLMCommandPhase inPhase, void* inRefcon)
+{
+    if (inPhase == xplm_CommandEnd)
+    {
+        environment->saveTrace();
+    }
+    return 0;
+}
+
+int ToggleSessionRecordingCommandHandler(XPLMCommandRef inCommand, XPLMCommandPhase inPhase, void* inRefcon)
+{
+    if (inPhase == xplm_CommandEnd)
+    {
+        environment->toggleSessionRecording();
+    }
+    return 0;
+}
+
+int ReplaySessionCommandHandler(XPLMCommandRef inCommand, XPLMCommandPhase inPhase, void* inRefcon)
+{
+    if (inPhase == xplm_CommandEnd)
+    {
+        // refcon 1 replays as fast as possible, 0 with the recorded timing
+        environment->replaySession(inRefcon ? 0.0 : 1.0);
+    }
+    return 0;
+}
+
+int ToggleTrafficBenchmarkCommandHandler(XPLMCommandRef inCommand, XPLMCommandPhase inPhase, void* inRefcon)
+{
+    if (inPhase == xplm_CommandEnd)
+    {
+        environment->toggleTrafficBenchmark();
+    }
+    return 0;
+}
+
 void RegisterMenuItems()
 {
     PttCommand = XPLMCreateCommand("xpilot/ptt", "xPilot: Radio Push-To-Talk (PTT)");
@@ -250,6 +314,27 @@ void RegisterMenuItems()
     ToggleAircraftLabelsCommand = XPLMCreateCommand("xpilot/toggle_aircraft_labels", "xPilot: Toggle Aircraft Labels");
     XPLMRegisterCommandHandler(ToggleAircraftLabelsCommand, ToggleAircraftLabelsCommandHandler, 1, (void*)0);
 
+    ToggleDiagnosticsWindowCommand = XPLMCreateCommand("xpilot/toggle_diagnostics", "xPilot: Toggle Diagnostics Window");
+    XPLMRegisterCommandHandler(ToggleDiagnosticsWindowCommand, ToggleDiagnosticsWindowCommandHandler, 1, (void*)0);
+
+    ToggleTracingCommand = XPLMCreateCommand("xpilot/toggle_tracing", "xPilot: Start/Stop Timeline Tracing");
+    XPLMRegisterCommandHandler(ToggleTracingCommand, ToggleTracingCommandHandler, 1, (void*)0);
+
+    SaveTraceCommand = XPLMCreateCommand("xpilot/save_trace", "xPilot: Save Timeline Trace");
+    XPLMRegisterCommandHandler(SaveTraceCommand, SaveTraceCommandHandler, 1, (void*)0);
+
+    ToggleSessionRecordingCommand = XPLMCreateCommand("xpilot/toggle_session_recording", "xPilot: Toggle Socket Session Recording");
+    XPLMRegisterCommandHandler(ToggleSessionRecordingCommand, ToggleSessionRecordingCommandHandler, 1, (void*)0);
+
+    ReplaySessionCommand = XPLMCreateCommand("xpilot/replay_session", "xPilot: Replay Recorded Socket Session");
+    XPLMRegisterCommandHandler(ReplaySessionCommand, ReplaySessionCommandHandler, 1, (void*)0);
+
+    ReplaySessionFastCommand = XPLMCreateCommand("xpilot/replay_session_fast", "xPilot: Replay Recorded Socket Session (As Fast As Possible)");
+    XPLMRegisterCommandHandler(ReplaySessionFastCommand, ReplaySessionCommandHandler, 1, (void*)1);
+
+    ToggleTrafficBenchmarkCommand = XPLMCreateCommand("xpilot/toggle_traffic_benchmark", "xPilot: Start/Stop Synthetic Traffic Benchmark");
+    XPLMRegisterCommandHandler(ToggleTrafficBenchmarkCommand, ToggleTrafficBenchmarkCommandHandler, 1, (void*)0);
+
     XPLMRegisterCommandHandler(ContactAtcCommand, ContactAtcCommandHandler, 1, (void*)0);
 
     PluginMenuIdx = XPLMAppendMenuItem(XPLMFindPluginsMenu(), "xPilot", nullptr, 0);
@@ -262,12 +347,19 @@ void RegisterMenuItems()
     MenuDefaultAtis = XPLMAppendMenuItemWithCommand(PluginMenu, "Default ATIS", ToggleDefaultAtisCommand);
     MenuToggleTcas = XPLMAppendMenuItemWithCommand(PluginMenu, "Toggle TCAS", ToggleTcasCommand);
     MenuToggleAircraftLabels = XPLMAppendMenuItemWithCommand(PluginMenu, "Toggle Aircraft Labels", ToggleAircraftLabelsCommand);
+    MenuDiagnostics = XPLMAppendMenuItemWithCommand(PluginMenu, "Diagnostics", ToggleDiagnosticsWindowCommand);
+    MenuToggleTracing = XPLMAppendMenuItemWithCommand(PluginMenu, "Start Tracing", ToggleTracingCommand);
+    MenuSaveTrace = XPLMAppendMenuItemWithCommand(PluginMenu, "Save Trace", SaveTraceCommand);
+    MenuToggleSessionRecording = XPLMAppendMenuItemWithCommand(PluginMenu, "Start Session Recording", ToggleSessionRecordingCommand);
+    MenuReplaySession = XPLMAppendMenuItemWithCommand(PluginMenu, "Replay Recorded Session", ReplaySessionCommand);
 }
 
 void UpdateMenuItems()
 {
     XPLMSetMenuItemName(PluginMenu, MenuDefaultAtis, environment->isDefaultAtisDisabled() ? "Default ATIS: Disabled" : "Default ATIS: Enabled", 0);
     XPLMSetMenuItemName(PluginMenu, MenuToggleTcas, XPMPHasControlOfAIAircraft() ? "Release TCAS Control" : "Request TCAS Control", 0);
+    XPLMSetMenuItemName(PluginMenu, MenuToggleTracing, environment->isTracing() ? "Stop Tracing" : "Start Tracing", 0);
+    XPLMSetMenuItemName(PluginMenu, MenuToggleSessionRecording, environment->isSessionRecording() ? "Stop Session Recording" : "Start Session Recording", 0);
 }
 
 #ifdef _WIN32
@@ -0,0 +1,108 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include <chrono>
+#include <fstream>
+
+#include "PluginHash.h"
+#include "Utilities.h"
+#include "Tracer.h"
+#include "sha512.hh"
+
+namespace xpilot
+{
+	PluginHash::~PluginHash()
+	{
+		m_stopRequested = true;
+		if (m_thread.joinable())
+		{
+			m_thread.join();
+		}
+	}
+
+	void PluginHash::start(const std::string& path)
+	{
+		m_thread = std::thread(&PluginHash::compute, this, path);
+	}
+
+	bool PluginHash::isReady()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_ready;
+	}
+
+	void PluginHash::get(const Callback& callback)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		if (!m_ready)
+		{
+			m_waiting.push_back(callback);
+			return;
+		}
+		const std::string hash = m_hash;
+		lock.unlock();
+		callback(hash);
+	}
+
+	void PluginHash::compute(const std::string& path)
+	{
+		Tracer::Instance().setThreadName("Plugin Hash");
+		TraceScope trace("Hash Plugin");
+		const auto begin = std::chrono::steady_clock::now();
+
+		// sw::sha512::file reads 64 bytes at a time; large reads are what makes this fast
+		std::string hash;
+		std::ifstream in(path, std::ios::in | std::ios::binary);
+		if (in)
+		{
+			constexpr size_t BlockSize = 1 << 20;
+			std::vector<char> block(BlockSize);
+			sw::sha512 sha;
+			while (!m_stopRequested && in.read(block.data(), block.size()).gcount() > 0)
+			{
+				sha.update(block.data(), static_cast<size_t>(in.gcount()));
+			}
+			if (in.eof() && !m_stopRequested)
+			{
+				hash = sha.final_data();
+			}
+		}
+
+		const auto micros = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count();
+		if (hash.empty())
+		{
+			LOG_MSG(logERROR, "Could not compute the plugin hash of %s", path.c_str());
+		}
+		else
+		{
+			LOG_MSG(logDEBUG, "Computed the plugin hash in %.1f ms", micros / 1000.0);
+		}
+
+		std::vector<Callback> waiting;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_hash = hash;
+			m_ready = true;
+			waiting.swap(m_waiting);
+		}
+		for (const Callback& callback : waiting)
+		{
+			callback(hash);
+		}
+	}
+}
@@ -0,0 +1,90 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include <algorithm>
+
+#include "Profiler.h"
+
+namespace xpilot
+{
+	const char* ProfilerStageName(ProfilerStage stage)
+	{
+		switch (stage)
+		{
+		case ProfilerStage::QueuedCallbacks: return "Queued Callbacks";
+		case ProfilerStage::Interpolation: return "Interpolation";
+		case ProfilerStage::MenuUpdate: return "Menu Update";
+		case ProfilerStage::UpdatePosition: return "XPMP2 UpdatePosition";
+		case ProfilerStage::NotificationPanel: return "Notification Panel Loop";
+		case ProfilerStage::NotificationPanelWindow: return "Notification Panel";
+		case ProfilerStage::TextMessageConsoleWindow: return "Message Console";
+		case ProfilerStage::NearbyAtcWindow: return "Nearby ATC";
+		case ProfilerStage::SettingsWindow: return "Settings";
+		case ProfilerStage::DiagnosticsWindow: return "Diagnostics";
+		default: return "";
+		}
+	}
+
+	Profiler& Profiler::Instance()
+	{
+		static auto&& profiler = Profiler();
+		return profiler;
+	}
+
+	void Profiler::setEnabled(bool enabled)
+	{
+		if (enabled && !isEnabled())
+		{
+			// drop whatever scopes finished while we were switched off
+			m_current.micros.fill(0);
+		}
+		m_enabled.store(enabled, std::memory_order_relaxed);
+	}
+
+	void Profiler::endFrame()
+	{
+		const uint64_t frame = m_frameCount.load(std::memory_order_relaxed);
+		m_current.frame = frame;
+		m_history[frame % HistorySize] = m_current;
+		m_frameCount.store(frame + 1, std::memory_order_release);
+		m_current.micros.fill(0);
+	}
+
+	bool Profiler::lastFrame(ProfilerFrame& frame)const
+	{
+		const uint64_t count = m_frameCount.load(std::memory_order_acquire);
+		if (count == 0)
+			return false;
+
+		frame = m_history[(count - 1) % HistorySize];
+		return true;
+	}
+
+	void Profiler::snapshot(std::vector<ProfilerFrame>& frames, size_t maxFrames)const
+	{
+		const uint64_t count = m_frameCount.load(std::memory_order_acquire);
+		const uint64_t available = (std::min)(static_cast<uint64_t>((std::min)(maxFrames, HistorySize)), count);
+
+		frames.clear();
+		frames.reserve(static_cast<size_t>(available));
+		for (uint64_t i = count - available; i < count; i++)
+		{
+			frames.push_back(m_history[i % HistorySize]);
+		}
+	}
+}
@@ -0,0 +1,241 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include <iterator>
+
+#include "SessionCapture.h"
+#include "Utilities.h"
+#include "Tracer.h"
+
+namespace xpilot
+{
+	namespace
+	{
+		void writeVarint(std::ofstream& out, uint64_t v)
+		{
+			char buf[10];
+			size_t n = 0;
+			do
+			{
+				uint8_t b = v & 0x7F;
+				v >>= 7;
+				if (v) b |= 0x80;
+				buf[n++] = static_cast<char>(b);
+			} while (v);
+			out.write(buf, n);
+		}
+
+		bool readVarint(const std::string& data, size_t& pos, uint64_t& v)
+		{
+			v = 0;
+			for (int shift = 0; shift < 64; shift += 7)
+			{
+				if (pos >= data.size())
+					return false;
+				const uint8_t b = static_cast<uint8_t>(data[pos++]);
+				v |= static_cast<uint64_t>(b & 0x7F) << shift;
+				if (!(b & 0x80))
+					return true;
+			}
+			return false;
+		}
+	}
+
+	bool ReadCaptureFile(const std::string& path, std::vector<CapturedMessage>& messages)
+	{
+		std::ifstream in(path, std::ios::binary);
+		if (!in)
+			return false;
+
+		const std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+		if (data.size() < 8 || data.compare(0, 4, CaptureFileMagic, 4) != 0)
+			return false;
+
+		const uint32_t version = static_cast<uint8_t>(data[4]) | (static_cast<uint8_t>(data[5]) << 8)
+			| (static_cast<uint8_t>(data[6]) << 16) | (static_cast<uint32_t>(static_cast<uint8_t>(data[7])) << 24);
+		if (version != CaptureFileVersion)
+			return false;
+
+		messages.clear();
+		size_t pos = 8;
+		uint64_t offset = 0;
+		while (pos < data.size())
+		{
+			uint64_t delta, length;
+			if (!readVarint(data, pos, delta) || !readVarint(data, pos, length) || length > data.size() - pos)
+			{
+				// a truncated tail (e.g. X-Plane crashed while recording) still leaves a usable capture
+				break;
+			}
+			offset += delta;
+			messages.push_back({ offset, data.substr(pos, static_cast<size_t>(length)) });
+			pos += static_cast<size_t>(length);
+		}
+		return true;
+	}
+
+	SessionRecorder::~SessionRecorder()
+	{
+		stop();
+	}
+
+	bool SessionRecorder::start(const std::string& path)
+	{
+		stop();
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_file.open(path, std::ios::binary | std::ios::trunc);
+		if (!m_file)
+		{
+			LOG_CAT(Network, logERROR, "Could not open capture file for writing: %s", path.c_str());
+			return false;
+		}
+
+		const uint8_t version[4] = {
+			static_cast<uint8_t>(CaptureFileVersion & 0xFF),
+			static_cast<uint8_t>((CaptureFileVersion >> 8) & 0xFF),
+			static_cast<uint8_t>((CaptureFileVersion >> 16) & 0xFF),
+			static_cast<uint8_t>((CaptureFileVersion >> 24) & 0xFF)
+		};
+		m_file.write(CaptureFileMagic, sizeof(CaptureFileMagic));
+		m_file.write(reinterpret_cast<const char*>(version), sizeof(version));
+
+		m_path = path;
+		m_count = 0;
+		m_bytes = 0;
+		m_lastRecord = std::chrono::steady_clock::now();
+		m_recording = true;
+		LOG_CAT(Network, logMSG, "Recording socket session to %s", path.c_str());
+		return true;
+	}
+
+	void SessionRecorder::stop()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_recording)
+			return;
+
+		m_recording = false;
+		m_file.close();
+		LOG_CAT(Network, logMSG, "Stopped recording socket session: %llu messages, %llu bytes written to %s",
+			(unsigned long long)m_count, (unsigned long long)m_bytes, m_path.c_str());
+	}
+
+	void SessionRecorder::record(const std::string& msg)
+	{
+		if (!m_recording)
+			return;
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_recording)
+			return;
+
+		const auto now = std::chrono::steady_clock::now();
+		const auto delta = std::chrono::duration_cast<std::chrono::microseconds>(now - m_lastRecord).count();
+		m_lastRecord = now;
+
+		writeVarint(m_file, static_cast<uint64_t>(delta));
+		writeVarint(m_file, msg.size());
+		m_file.write(msg.data(), msg.size());
+		m_count++;
+		m_bytes += msg.size();
+	}
+
+	SessionPlayer::SessionPlayer(MessageHandler handler) :
+		m_handler(handler)
+	{
+	}
+
+	SessionPlayer::~SessionPlayer()
+	{
+		stop();
+	}
+
+	bool SessionPlayer::start(const std::string& path, double speed)
+	{
+		stop();
+
+		std::vector<CapturedMessage> messages;
+		if (!ReadCaptureFile(path, messages))
+		{
+			LOG_CAT(Network, logERROR, "Could not read capture file: %s", path.c_str());
+			return false;
+		}
+
+		LOG_CAT(Network, logMSG, "Replaying %llu messages from %s (%s)", (unsigned long long)messages.size(), path.c_str(),
+			speed > 0.0 ? string_format("%.1fx", speed).c_str() : "as fast as possible");
+
+		m_stopRequested = false;
+		m_playing = true;
+		m_thread = std::make_unique<std::thread>(&SessionPlayer::run, this, std::move(messages), speed);
+		return true;
+	}
+
+	void SessionPlayer::stop()
+	{
+		if (m_thread)
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_stopRequested = true;
+			}
+			m_cv.notify_all();
+			m_thread->join();
+			m_thread.reset();
+		}
+		m_playing = false;
+	}
+
+	void SessionPlayer::run(std::vector<CapturedMessage> messages, double speed)
+	{
+		const auto begin = std::chrono::steady_clock::now();
+		size_t played = 0;
+
+		Tracer::Instance().setThreadName("Session Replay");
+
+		for (const CapturedMessage& m : messages)
+		{
+			if (speed > 0.0)
+			{
+				const auto due = begin + std::chrono::microseconds(static_cast<long long>(m.offsetMicros / speed));
+				std::unique_lock<std::mutex> lock(m_mutex);
+				if (m_cv.wait_until(lock, due, [this] { return m_stopRequested.load(); }))
+					break;
+			}
+			else if (m_stopRequested)
+			{
+				break;
+			}
+
+			try
+			{
+				m_handler(m.payload);
+			}
+			catch (std::exception& e)
+			{
+				LOG_CAT(Network, logERROR, "Replay exception: %s", e.what());
+			}
+			played++;
+		}
+
+		const double elapsedMs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count() / 1000.0;
+		LOG_CAT(Network, logMSG, "Replay finished: %llu of %llu messages in %.1f ms (%.0f msg/s)", (unsigned long long)played,
+			(unsigned long long)messages.size(), elapsedMs, elapsedMs > 0.0 ? played * 1000.0 / elapsedMs : 0.0);
+		m_playing = false;
+	}
+}
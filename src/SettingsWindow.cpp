@@ -24,6 +24,7 @@
 #include "Config.h"
 #include "SettingsWindow.h"
 #include "XPMPMultiplayer.h"
+#include "Profiler.h"
 
 namespace xpilot
 {
@@ -41,6 +42,11 @@ namespace xpilot
 	static int messagePreviewTimeout = 2;
 	static int labelMaxDistance = 3;
 	static bool labelVisibilityCutoff = true;
+	static bool adaptiveJitterBuffer;
+	static bool cubicInterpolation;
+	static int modelLoadDistance;
+	static int maxLoadedModels = 100;
+	static int consoleHistoryLimit = 1000;
 	static float lblCol[4];
 	ImGui::FileBrowser fileBrowser(ImGuiFileBrowserFlags_SelectDirectory);
 
@@ -82,6 +88,11 @@ namespace xpilot
 		labelMaxDistance = xpilot::Config::Instance().getMaxLabelDistance();
 		labelVisibilityCutoff = xpilot::Config::Instance().getLabelCutoffVis();
 		logLevel = xpilot::Config::Instance().getLogLevel();
+		adaptiveJitterBuffer = xpilot::Config::Instance().getAdaptiveJitterBuffer();
+		cubicInterpolation = xpilot::Config::Instance().getCubicInterpolation();
+		modelLoadDistance = xpilot::Config::Instance().getModelLoadDistance();
+		maxLoadedModels = xpilot::Config::Instance().getMaxLoadedModels();
+		consoleHistoryLimit = xpilot::Config::Instance().getConsoleHistoryLimit();
 		HexToRgb(xpilot::Config::Instance().getAircraftLabelColor(), lblCol);
 	}
 
@@ -89,12 +100,14 @@ namespace xpilot
 	{
 		if (!xpilot::Config::Instance().saveConfig())
 		{
+			LOG_CAT(Ui, logERROR, "Could not save the settings to Config.json");
 			ImGui::OpenPopup("Error Saving Settings");
 		}
 	}
 
 	void SettingsWindow::buildInterface()
 	{
+		ProfileScope profile(ProfilerStage::SettingsWindow);
 		loadConfig();
 		ImGui::PushFont(0);
 
@@ -292,6 +305,71 @@ namespace xpilot
 						Save();
 					}
 
+					ImGui::TableNextRow();
+					ImGui::TableSetColumnIndex(0);
+					ImGui::AlignTextToFramePadding();
+					ImGui::Text("Adaptive Interpolation Delay");
+					ImGui::SameLine();
+					ImGui::ButtonIcon(ICON_FA_QUESTION_CIRCLE, "Network aircraft are normally drawn 5.5 seconds behind their last reported position, so there is always a newer position to move towards.\n\nIf enabled, xPilot measures how regularly position updates arrive and uses the shortest delay that still keeps aircraft moving smoothly.\n\nDisable this option if aircraft stutter or pause.");
+					ImGui::TableSetColumnIndex(1);
+					if (ImGui::Checkbox("##AdaptiveJitterBuffer", &adaptiveJitterBuffer))
+					{
+						xpilot::Config::Instance().setAdaptiveJitterBuffer(adaptiveJitterBuffer);
+						Save();
+					}
+
+					ImGui::TableNextRow();
+					ImGui::TableSetColumnIndex(0);
+					ImGui::AlignTextToFramePadding();
+					ImGui::Text("Smooth Aircraft Turns");
+					ImGui::SameLine();
+					ImGui::ButtonIcon(ICON_FA_QUESTION_CIRCLE, "If enabled, network aircraft follow a curved path through their reported positions instead of flying straight lines between them.\n\nThis removes the small kinks every few seconds in turning traffic, most noticeable on final approach.");
+					ImGui::TableSetColumnIndex(1);
+					if (ImGui::Checkbox("##CubicInterpolation", &cubicInterpolation))
+					{
+						xpilot::Config::Instance().setCubicInterpolation(cubicInterpolation);
+						Save();
+					}
+
+					ImGui::TableNextRow();
+					ImGui::TableSetColumnIndex(0);
+					ImGui::AlignTextToFramePadding();
+					ImGui::Text("Load Liveries Within (nm)");
+					ImGui::SameLine();
+					ImGui::ButtonIcon(ICON_FA_QUESTION_CIRCLE, "Aircraft further away than this are shown with a generic model of their type, and only get their airline's livery once they come closer. This keeps memory use down at busy events.\n\nSet to \"Always\" to load every aircraft's livery right away.");
+					ImGui::TableSetColumnIndex(1);
+					if (ImGui::SliderInt("##ModelLoadDistance", &modelLoadDistance, 0, 100, modelLoadDistance == 0 ? "Always" : "%d nm"))
+					{
+						xpilot::Config::Instance().setModelLoadDistance(modelLoadDistance);
+						Save();
+					}
+
+					ImGui::TableNextRow();
+					ImGui::TableSetColumnIndex(0);
+					ImGui::AlignTextToFramePadding();
+					ImGui::Text("Max Loaded Liveries");
+					ImGui::SameLine();
+					ImGui::ButtonIcon(ICON_FA_QUESTION_CIRCLE, "How many different models may stay loaded for aircraft that are no longer within \"Load Liveries Within\". Beyond this, the ones not needed for the longest time are unloaded.\n\nOnly used when \"Load Liveries Within\" is not set to \"Always\".");
+					ImGui::TableSetColumnIndex(1);
+					if (ImGui::SliderInt("##MaxLoadedModels", &maxLoadedModels, 10, 500))
+					{
+						xpilot::Config::Instance().setMaxLoadedModels(maxLoadedModels);
+						Save();
+					}
+
+					ImGui::TableNextRow();
+					ImGui::TableSetColumnIndex(0);
+					ImGui::AlignTextToFramePadding();
+					ImGui::Text("Message History Length");
+					ImGui::SameLine();
+					ImGui::ButtonIcon(ICON_FA_QUESTION_CIRCLE, "How many messages the text message console keeps in each tab. Older messages are removed once there are more.");
+					ImGui::TableSetColumnIndex(1);
+					if (ImGui::SliderInt("##ConsoleHistoryLimit", &consoleHistoryLimit, 100, 5000))
+					{
+						xpilot::Config::Instance().setConsoleHistoryLimit(consoleHistoryLimit);
+						Save();
+					}
+
 					ImGui::TableNextRow();
 					ImGui::TableSetColumnIndex(0);
 					ImGui::AlignTextToFramePadding();
@@ -0,0 +1,140 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include <algorithm>
+
+#include "StartupScheduler.h"
+#include "Utilities.h"
+#include "Tracer.h"
+
+namespace xpilot
+{
+	void StartupScheduler::add(const std::string& name, const std::vector<std::string>& dependencies, const Step& step)
+	{
+		Phase phase;
+		phase.name = name;
+		phase.traceName = Tracer::Instance().intern(name);
+		phase.dependencies = dependencies;
+		phase.step = step;
+		m_phases.push_back(phase);
+	}
+
+	void StartupScheduler::addCompleted(const std::string& name, std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end)
+	{
+		if (!m_hasEnableTime || begin < m_enableTime)
+		{
+			m_enableTime = begin;
+			m_hasEnableTime = true;
+		}
+
+		Phase phase;
+		phase.name = name;
+		phase.done = true;
+		phase.startedAt = sinceEnable(begin);
+		phase.finishedAt = sinceEnable(end);
+		phase.simMicros = phase.finishedAt - phase.startedAt;
+		m_phases.push_back(phase);
+	}
+
+	bool StartupScheduler::isDone(const std::string& name)const
+	{
+		auto it = std::find_if(m_phases.begin(), m_phases.end(), [&name](const Phase& p) { return p.name == name; });
+		return it != m_phases.end() && it->done;
+	}
+
+	long long StartupScheduler::sinceEnable(std::chrono::steady_clock::time_point t)const
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(t - m_enableTime).count();
+	}
+
+	bool StartupScheduler::run(std::chrono::microseconds budget)
+	{
+		if (m_finished)
+			return true;
+
+		const auto begin = std::chrono::steady_clock::now();
+		if (m_frames++ == 0)
+		{
+			if (!m_hasEnableTime)
+			{
+				m_enableTime = begin;
+				m_hasEnableTime = true;
+			}
+			m_firstFrameAt = sinceEnable(begin);
+		}
+		const auto deadline = begin + budget;
+
+		for (Phase& phase : m_phases)
+		{
+			if (std::chrono::steady_clock::now() >= deadline)
+				break;
+			if (phase.done)
+				continue;
+			if (!std::all_of(phase.dependencies.begin(), phase.dependencies.end(), [this](const std::string& d) { return isDone(d); }))
+				continue;
+
+			TraceScope trace(phase.traceName);
+			const auto stepBegin = std::chrono::steady_clock::now();
+			if (phase.startedAt < 0)
+			{
+				phase.startedAt = sinceEnable(stepBegin);
+			}
+			phase.frames++;
+			phase.done = phase.step();
+
+			const auto stepEnd = std::chrono::steady_clock::now();
+			phase.simMicros += std::chrono::duration_cast<std::chrono::microseconds>(stepEnd - stepBegin).count();
+			if (phase.done)
+			{
+				phase.finishedAt = sinceEnable(stepEnd);
+			}
+		}
+
+		if (!std::all_of(m_phases.begin(), m_phases.end(), [](const Phase& p) { return p.done; }))
+			return false;
+
+		m_finished = true;
+		report();
+		return true;
+	}
+
+	void StartupScheduler::report()const
+	{
+		const long long totalMicros = sinceEnable(std::chrono::steady_clock::now());
+		long long simMicros = 0;
+		for (const Phase& phase : m_phases)
+		{
+			simMicros += phase.simMicros;
+		}
+
+		LOG_MSG(logMSG, "Startup finished %.0f ms after the plugin was enabled, over %u frame(s) from the first at %.0f ms; %.0f ms of it on the sim thread",
+			totalMicros / 1000.0, m_frames, m_firstFrameAt / 1000.0, simMicros / 1000.0);
+		for (const Phase& phase : m_phases)
+		{
+			if (phase.frames == 0)
+			{
+				LOG_MSG(logMSG, "  %-16s %8.1f ms during plugin enable", phase.name.c_str(), phase.simMicros / 1000.0);
+			}
+			else
+			{
+				LOG_MSG(logMSG, "  %-16s %8.1f ms on the sim thread over %u frame(s), done at %.0f ms (started at %.0f ms)",
+					phase.name.c_str(), phase.simMicros / 1000.0, phase.frames, phase.finishedAt / 1000.0, phase.startedAt / 1000.0);
+			}
+		}
+	}
+}
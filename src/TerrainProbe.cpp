@@ -16,10 +16,16 @@
  * along with this program. If not, see http://www.gnu.org/licenses/.
 */
 
+#include <limits>
+
 #include "TerrainProbe.h"
+#include "Tracer.h"
+#include "Utilities.h"
 
 namespace xpilot
 {
+    uint64_t TerrainProbe::s_probeCount = 0;
+
     TerrainProbe::TerrainProbe() :
         m_probeRef(XPLMCreateProbe(xplm_ProbeY))
     {
@@ -33,20 +39,24 @@ namespace xpilot
 
     double TerrainProbe::getTerrainElevation(double degLat, double degLon) const
     {
+        TraceScope trace("Terrain Probe");
         double x, y, z, foo, alt;
         XPLMProbeInfo_t probeinfo;
         probeinfo.structSize = sizeof(XPLMProbeInfo_t);
 
         XPLMWorldToLocal(degLat, degLon, 0, &x, &y, &z);
         XPLMProbeTerrainXYZ(m_probeRef, x, y, z, &probeinfo);
+        s_probeCount++;
         XPLMLocalToWorld(probeinfo.locationX, probeinfo.locationY, probeinfo.locationZ, &foo, &foo, &alt);
         XPLMWorldToLocal(degLat, degLon, alt, &x, &y, &z);
+        s_probeCount++;
         if (XPLMProbeTerrainXYZ(m_probeRef, x, y, z, &probeinfo) == xplm_ProbeHitTerrain) 
         {
             XPLMLocalToWorld(probeinfo.locationX, probeinfo.locationY, probeinfo.locationZ, &foo, &foo, &alt);
             return alt * 3.28084;
         }
 
-        return 0;
+        LOG_CAT(Terrain, logDEBUG, "Terrain probe found no terrain at %.5f, %.5f", degLat, degLon);
+        return std::numeric_limits<double>::quiet_NaN();
     }
 }
\ No newline at end of file
@@ -21,6 +21,7 @@
 #include "TextMessageConsole.h"
 #include "Utilities.h"
 #include "XPilot.h"
+#include "Profiler.h"
 #include "json.hpp"
 
 using json = nlohmann::json;
@@ -28,7 +29,7 @@ using json = nlohmann::json;
 namespace xpilot
 {
 	static std::string InputValue;
-	static std::list<ConsoleMessage> MessageHistory;
+	static ConsoleHistory MessageHistory;
 	static std::list<Tab> Tabs;
 
 	enum class CommandOptions
@@ -52,6 +53,59 @@ namespace xpilot
 		return xpilot::CommandOptions::None;
 	}
 
+	void ConsoleHistory::push(const ConsoleMessage& message)
+	{
+		m_messages.push_back(message);
+		const size_t limit = static_cast<size_t>(Config::Instance().getConsoleHistoryLimit());
+		while (m_messages.size() > limit)
+		{
+			m_messages.pop_front();
+		}
+	}
+
+	void ConsoleHistory::draw()
+	{
+		// ImGuiListClipper needs rows of equal height, wrapped messages aren't; the cached
+		// heights tell which messages are in view, the rest is stood in for by empty space
+		const float width = ImGui::GetContentRegionAvail().x;
+		const float spacing = ImGui::GetStyle().ItemSpacing.y;
+		const float viewTop = ImGui::GetScrollY();
+		const float viewBottom = viewTop + ImGui::GetWindowHeight();
+
+		float y = 0.0f;
+		size_t i = 0;
+		for (; i < m_messages.size(); i++)
+		{
+			const float row = m_messages[i].getHeight(width) + spacing;
+			if (y + row >= viewTop) break;
+			y += row;
+		}
+		if (y > 0.0f)
+		{
+			ImGui::Dummy(ImVec2(1.0f, y - spacing));
+		}
+
+		for (; i < m_messages.size() && y <= viewBottom; i++)
+		{
+			ConsoleMessage& e = m_messages[i];
+			y += e.getHeight(width) + spacing;
+			const ImVec4& color = ImVec4(e.getRed(), e.getGreen(), e.getBlue(), 1.0f);
+			ImGui::PushStyleColor(ImGuiCol_Text, color);
+			ImGui::TextWrapped("%s", e.getMessage().c_str());
+			ImGui::PopStyleColor();
+		}
+
+		float below = 0.0f;
+		for (; i < m_messages.size(); i++)
+		{
+			below += m_messages[i].getHeight(width) + spacing;
+		}
+		if (below > 0.0f)
+		{
+			ImGui::Dummy(ImVec2(1.0f, below - spacing));
+		}
+	}
+
 	TextMessageConsole::TextMessageConsole(XPilot* instance) :
 		XPImgWindow(WND_MODE_FLOAT_CENTERED, WND_STYLE_SOLID, WndRect(0, 200, 600, 0)),
 		m_scrollToBottom(false),
@@ -81,7 +135,7 @@ namespace xpilot
 			m.setRed(red);
 			m.setGreen(green);
 			m.setBlue(blue);
-			MessageHistory.push_back(m);
+			MessageHistory.push(m);
 			m_scrollToBottom = true;
 		}
 	}
@@ -93,7 +147,7 @@ namespace xpilot
 		m.setRed(255);
 		m.setGreen(255);
 		m.setBlue(255);
-		MessageHistory.push_back(m);
+		MessageHistory.push(m);
 		sendSocketMessage(msg);
 		m_scrollToBottom = true;
 	}
@@ -105,7 +159,7 @@ namespace xpilot
 		m.setRed(192);
 		m.setGreen(57);
 		m.setBlue(43);
-		MessageHistory.push_back(m);
+		MessageHistory.push(m);
 		m_scrollToBottom = true;
 	}
 
@@ -155,7 +209,6 @@ namespace xpilot
 			Tab tab;
 			tab.tabName = tabName;
 			tab.isOpen = true;
-			tab.messageHistory = std::list<ConsoleMessage>();
 			Tabs.push_back(tab);
 		}
 	}
@@ -179,7 +232,7 @@ namespace xpilot
 
 			if (it != Tabs.end())
 			{
-				it->messageHistory.push_back(m);
+				it->messageHistory.push(m);
 				it->scrollToBottom = true;
 			}
 			else
@@ -204,7 +257,7 @@ namespace xpilot
 
 			if (it != Tabs.end())
 			{
-				it->messageHistory.push_back(m);
+				it->messageHistory.push(m);
 				it->scrollToBottom = true;
 			}
 			else
@@ -231,6 +284,7 @@ namespace xpilot
 
 	void TextMessageConsole::buildInterface()
 	{
+		ProfileScope profile(ProfilerStage::TextMessageConsoleWindow);
 		ImGui::PushFont(0);
 
 		if (ImGui::BeginTabBar("##Tabs", ImGuiTabBarFlags_AutoSelectNewTabs | ImGuiTabBarFlags_NoTooltip))
@@ -239,13 +293,7 @@ namespace xpilot
 			{
 				ImGui::BeginChild("##Messages", ImVec2(0, -ImGui::GetFrameHeightWithSpacing()), false);
 				{
-					for (auto& e : MessageHistory)
-					{
-						const ImVec4& color = ImVec4(e.getRed(), e.getGreen(), e.getBlue(), 1.0f);
-						ImGui::PushStyleColor(ImGuiCol_Text, color);
-						ImGui::TextWrapped(e.getMessage().c_str());
-						ImGui::PopStyleColor();
-					}
+					MessageHistory.draw();
 					if (m_scrollToBottom)
 					{
 						ImGui::SetScrollHere(1.0f);
@@ -358,13 +406,7 @@ namespace xpilot
 				{
 					ImGui::BeginChild(key.c_str(), ImVec2(0, -ImGui::GetFrameHeightWithSpacing()), false);
 					{
-						for (auto& e : it->messageHistory)
-						{
-							const ImVec4& color = ImVec4(e.getRed(), e.getGreen(), e.getBlue(), 1.0f);
-							ImGui::PushStyleColor(ImGuiCol_Text, color);
-							ImGui::TextWrapped(e.getMessage().c_str());
-							ImGui::PopStyleColor();
-						}
+						it->messageHistory.draw();
 						if (it->scrollToBottom)
 						{
 							ImGui::SetScrollHere(1.0f);
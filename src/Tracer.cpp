@@ -0,0 +1,156 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include <algorithm>
+#include <fstream>
+
+#include "Tracer.h"
+#include "Utilities.h"
+
+namespace xpilot
+{
+	namespace
+	{
+		// buffers are only allocated once a thread records its first event, until then
+		// the name given by setThreadName is kept here
+		thread_local TraceBuffer* CurrentThreadBuffer = nullptr;
+		thread_local std::string CurrentThreadName;
+
+		// releases the thread's buffer for reuse when the thread exits
+		struct ThreadBufferOwner
+		{
+			TraceBuffer* buffer = nullptr;
+			~ThreadBufferOwner()
+			{
+				if (buffer) buffer->threadExited.store(true, std::memory_order_release);
+			}
+		};
+		thread_local ThreadBufferOwner CurrentThreadBufferOwner;
+	}
+
+	Tracer& Tracer::Instance()
+	{
+		static auto&& tracer = Tracer();
+		return tracer;
+	}
+
+	Tracer::Tracer() :
+		m_origin(std::chrono::steady_clock::now())
+	{
+	}
+
+	TraceBuffer* Tracer::threadBuffer()
+	{
+		if (!CurrentThreadBuffer)
+		{
+			std::lock_guard<std::mutex> lock(m_buffersMutex);
+
+			// the events of an exited thread stay in the trace until another thread needs the buffer
+			TraceBuffer* b = nullptr;
+			for (const auto& buffer : m_buffers)
+			{
+				if (buffer->threadExited.load(std::memory_order_acquire))
+				{
+					b = buffer.get();
+					b->threadExited.store(false, std::memory_order_relaxed);
+					b->count.store(0, std::memory_order_relaxed);
+					break;
+				}
+			}
+			if (!b)
+			{
+				m_buffers.push_back(std::make_unique<TraceBuffer>());
+				b = m_buffers.back().get();
+				b->events.resize(TraceBuffer::Capacity);
+			}
+
+			b->threadId = m_nextThreadId++;
+			b->threadName = CurrentThreadName.empty() ? string_format("Thread %u", b->threadId) : CurrentThreadName;
+			CurrentThreadBuffer = b;
+			CurrentThreadBufferOwner.buffer = b;
+		}
+		return CurrentThreadBuffer;
+	}
+
+	void Tracer::setThreadName(const std::string& name)
+	{
+		CurrentThreadName = name;
+		if (CurrentThreadBuffer)
+		{
+			std::lock_guard<std::mutex> lock(m_buffersMutex);
+			CurrentThreadBuffer->threadName = name;
+		}
+	}
+
+	void Tracer::record(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+	{
+		TraceBuffer* buffer = threadBuffer();
+		const uint64_t n = buffer->count.load(std::memory_order_relaxed);
+
+		TraceEvent& ev = buffer->events[n % TraceBuffer::Capacity];
+		ev.name = name;
+		ev.start = std::chrono::duration_cast<std::chrono::microseconds>(start - m_origin).count();
+		ev.duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+
+		buffer->count.store(n + 1, std::memory_order_release);
+	}
+
+	const char* Tracer::intern(const std::string& name)
+	{
+		std::lock_guard<std::mutex> lock(m_namesMutex);
+		return m_names.insert(name).first->c_str();
+	}
+
+	bool Tracer::dump(const std::string& path)
+	{
+		std::ofstream file(path);
+		if (!file)
+		{
+			LOG_MSG(logERROR, "Could not write trace to %s", path.c_str());
+			return false;
+		}
+
+		size_t total = 0;
+		file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+		std::lock_guard<std::mutex> lock(m_buffersMutex);
+		bool first = true;
+		for (const auto& buffer : m_buffers)
+		{
+			file << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadId
+				<< ",\"args\":{\"name\":\"" << buffer->threadName << "\"}}";
+			first = false;
+
+			// threads keep recording while we read; the oldest entries of a busy ring may be
+			// overwritten mid-dump, which at worst garbles a few events at the start of the trace
+			const uint64_t count = buffer->count.load(std::memory_order_acquire);
+			const uint64_t available = (std::min)(count, static_cast<uint64_t>(TraceBuffer::Capacity));
+			for (uint64_t i = count - available; i < count; i++)
+			{
+				const TraceEvent& ev = buffer->events[i % TraceBuffer::Capacity];
+				file << ",\n{\"name\":\"" << ev.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadId
+					<< ",\"ts\":" << ev.start << ",\"dur\":" << ev.duration << "}";
+			}
+			total += static_cast<size_t>(available);
+		}
+
+		file << "\n]}\n";
+		LOG_MSG(logMSG, "Wrote %u trace events to %s", (unsigned)total, path.c_str());
+		return true;
+	}
+}
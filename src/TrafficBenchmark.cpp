@@ -0,0 +1,380 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include <algorithm>
+#include <fstream>
+#include <cmath>
+#include <set>
+
+#include "TrafficBenchmark.h"
+#include "Constants.h"
+#include "Utilities.h"
+#include "Config.h"
+
+using json = nlohmann::json;
+
+namespace xpilot
+{
+	namespace
+	{
+		constexpr double Pi = 3.14159265358979323846;
+
+		const size_t StepAircraftCounts[] = { 10, 50, 100, 250, 500, 1000, 2000 };
+		constexpr size_t StepCount = sizeof(StepAircraftCounts) / sizeof(StepAircraftCounts[0]);
+
+		// positions only start to interpolate once the 5.5s delay has passed
+		constexpr auto WarmupDuration = std::chrono::seconds(8);
+		constexpr auto MeasureDuration = std::chrono::seconds(20);
+
+		// VATSIM sends position updates every 5 seconds
+		constexpr auto PositionInterval = std::chrono::seconds(5);
+
+		constexpr double GroundFraction = 0.25;
+		constexpr double AirborneRadiusNm = 60.0;
+		constexpr double GroundRadiusNm = 2.0;
+
+		const char* const Airlines[] = { "DAL", "AAL", "UAL", "SWA", "BAW", "DLH", "AFR", "KLM", "RYR", "EZY", "ACA", "QFA" };
+		const char* const AirlinerTypes[] = { "B738", "A320", "A321", "B77W", "A333", "B789", "E75L", "CRJ9" };
+		const char* const GeneralAviationTypes[] = { "C172", "PA28", "SR22", "BE36", "C208" };
+
+		template<typename T, size_t N>
+		const T& pick(std::mt19937& rng, const T(&values)[N])
+		{
+			return values[std::uniform_int_distribution<size_t>(0, N - 1)(rng)];
+		}
+
+		json summarize(std::vector<long long>& samples)
+		{
+			if (samples.empty())
+				return json::object();
+
+			std::sort(samples.begin(), samples.end());
+			auto percentile = [&](double p)
+			{
+				return samples[(std::min)(samples.size() - 1, static_cast<size_t>(p * samples.size()))];
+			};
+
+			long long sum = 0;
+			for (long long s : samples) sum += s;
+
+			return {
+				{ "p50", percentile(0.50) },
+				{ "p99", percentile(0.99) },
+				{ "max", samples.back() },
+				{ "mean", static_cast<double>(sum) / samples.size() }
+			};
+		}
+	}
+
+	TrafficBenchmark::TrafficBenchmark(MessageHandler handler) :
+		m_handler(handler),
+		m_rng(1338)
+	{
+	}
+
+	TrafficBenchmark::~TrafficBenchmark()
+	{
+	}
+
+	bool TrafficBenchmark::start(double originLat, double originLon, const std::string& resultPath)
+	{
+		if (m_running)
+			return false;
+
+		m_originLat = originLat;
+		m_originLon = originLon;
+		m_resultPath = resultPath;
+		m_results = json::array();
+		m_rng.seed(1338); // the same traffic on every run, so results are comparable
+		m_step = 0;
+		m_running = true;
+
+		LOG_MSG(logMSG, "Traffic benchmark started at %.4f, %.4f", originLat, originLon);
+		beginStep();
+		return true;
+	}
+
+	void TrafficBenchmark::stop()
+	{
+		if (!m_running)
+			return;
+
+		removeAircraft();
+		m_running = false;
+		writeResults();
+	}
+
+	void TrafficBenchmark::beginStep()
+	{
+		m_samples = StepSamples();
+		spawnAircraft(StepAircraftCounts[m_step]);
+		m_stepStart = std::chrono::steady_clock::now();
+	}
+
+	void TrafficBenchmark::finishStep()
+	{
+		const size_t frames = m_samples.total.size();
+		json stages = json::object();
+		for (size_t i = 0; i < ProfilerStageCount; i++)
+		{
+			stages[ProfilerStageName(static_cast<ProfilerStage>(i))] = summarize(m_samples.stages[i]);
+		}
+		stages["Total"] = summarize(m_samples.total);
+
+		json step = {
+			{ "aircraft", StepAircraftCounts[m_step] },
+			{ "frames", frames },
+			{ "stages", stages }
+		};
+		if (m_allocationCounter)
+		{
+			step["allocationsPerFrame"] = summarize(m_samples.allocations);
+		}
+
+		LOG_MSG(logMSG, "Traffic benchmark: %u aircraft, %u frames, total p50=%lldus p99=%lldus",
+			(unsigned)StepAircraftCounts[m_step], (unsigned)frames,
+			stages["Total"].value("p50", 0LL), stages["Total"].value("p99", 0LL));
+
+		m_results.push_back(step);
+		removeAircraft();
+	}
+
+	void TrafficBenchmark::onFrame(const ProfilerFrame& frame)
+	{
+		if (!m_running)
+			return;
+
+		const auto now = std::chrono::steady_clock::now();
+		if (now - m_stepStart >= WarmupDuration)
+		{
+			for (size_t i = 0; i < ProfilerStageCount; i++)
+			{
+				m_samples.stages[i].push_back(frame.micros[i]);
+			}
+			m_samples.total.push_back(frame.total());
+			if (m_allocationCounter)
+			{
+				m_samples.allocations.push_back(static_cast<long long>(m_allocationCounter() - m_allocationMark));
+			}
+		}
+
+		if (now - m_stepStart >= WarmupDuration + MeasureDuration)
+		{
+			finishStep();
+			if (++m_step >= StepCount)
+			{
+				m_running = false;
+				writeResults();
+				return;
+			}
+			beginStep();
+		}
+		else
+		{
+			for (auto& ac : m_aircraft)
+			{
+				if (now >= ac.nextUpdate)
+				{
+					sendPosition(ac, now);
+				}
+			}
+		}
+
+		// what it takes to make up the traffic isn't part of the frame
+		if (m_allocationCounter)
+		{
+			m_allocationMark = m_allocationCounter();
+		}
+	}
+
+	std::string TrafficBenchmark::nextCallsign(std::string& airline)
+	{
+		const double r = std::uniform_real_distribution<double>(0.0, 1.0)(m_rng);
+		if (r < 0.65)
+		{
+			// airline flight number, sometimes alphanumeric
+			airline = pick(m_rng, Airlines);
+			std::string callsign = airline + std::to_string(std::uniform_int_distribution<int>(1, 9999)(m_rng));
+			if (r < 0.15)
+			{
+				callsign += static_cast<char>('A' + std::uniform_int_distribution<int>(0, 25)(m_rng));
+			}
+			return callsign;
+		}
+
+		airline = "";
+		if (r < 0.9)
+		{
+			// US registration
+			std::string callsign = "N" + std::to_string(std::uniform_int_distribution<int>(100, 9999)(m_rng));
+			callsign += static_cast<char>('A' + std::uniform_int_distribution<int>(0, 25)(m_rng));
+			return callsign;
+		}
+
+		// european registration
+		std::string callsign = "G";
+		for (int i = 0; i < 4; i++)
+		{
+			callsign += static_cast<char>('A' + std::uniform_int_distribution<int>(0, 25)(m_rng));
+		}
+		return callsign;
+	}
+
+	void TrafficBenchmark::spawnAircraft(size_t count)
+	{
+		std::uniform_real_distribution<double> unit(0.0, 1.0);
+		std::set<std::string> callsigns;
+		const auto now = std::chrono::steady_clock::now();
+		const double nmToDegLat = 1.0 / 60.0;
+		const double nmToDegLon = nmToDegLat / (std::max)(0.01, std::cos(m_originLat * Pi / 180.0));
+
+		m_aircraft.clear();
+		m_aircraft.reserve(count);
+
+		while (m_aircraft.size() < count)
+		{
+			SyntheticAircraft ac{};
+			ac.callsign = nextCallsign(ac.airline);
+			if (!callsigns.insert(ac.callsign).second)
+				continue;
+
+			ac.onGround = unit(m_rng) < GroundFraction;
+			ac.typeCode = ac.airline.empty() ? pick(m_rng, GeneralAviationTypes) : pick(m_rng, AirlinerTypes);
+
+			const double radius = (ac.onGround ? GroundRadiusNm : AirborneRadiusNm) * std::sqrt(unit(m_rng));
+			const double bearing = unit(m_rng) * 2.0 * Pi;
+			ac.latitude = m_originLat + radius * std::cos(bearing) * nmToDegLat;
+			ac.longitude = m_originLon + radius * std::sin(bearing) * nmToDegLon;
+			ac.heading = unit(m_rng) * 360.0;
+
+			if (ac.onGround)
+			{
+				ac.altitude = 0.0;
+				ac.groundSpeed = unit(m_rng) < 0.5 ? 0.0 : 5.0 + unit(m_rng) * 20.0;
+			}
+			else
+			{
+				ac.altitude = 2000.0 + unit(m_rng) * 37000.0;
+				ac.groundSpeed = (ac.airline.empty() ? 100.0 : 250.0) + unit(m_rng) * 200.0;
+			}
+
+			// spread updates over the interval like real traffic
+			ac.lastUpdate = now;
+			ac.nextUpdate = now + std::chrono::milliseconds(std::uniform_int_distribution<int>(0, 4999)(m_rng));
+
+			json add = {
+				{ "Type", "AddPlane" },
+				{ "Data", {
+					{ "Callsign", ac.callsign },
+					{ "Airline", ac.airline },
+					{ "TypeCode", ac.typeCode }
+				}}
+			};
+			m_handler(add.dump());
+
+			json surfaces = {
+				{ "Type", "SurfaceUpdate" },
+				{ "Data", {
+					{ "Callsign", ac.callsign },
+					{ "OnGround", ac.onGround },
+					{ "GearDown", ac.onGround || ac.altitude < 4000.0 },
+					{ "EnginesOn", true },
+					{ "Flaps", ac.onGround ? 0.25f : 0.0f },
+					{ "SpoilersDeployed", false },
+					{ "ReverseThrust", false },
+					{ "Lights", {
+						{ "Strobes", !ac.onGround },
+						{ "Landing", ac.altitude < 10000.0 },
+						{ "Taxi", ac.onGround },
+						{ "Beacon", true },
+						{ "Nav", true }
+					}}
+				}}
+			};
+			m_handler(surfaces.dump());
+
+			m_aircraft.push_back(ac);
+		}
+	}
+
+	void TrafficBenchmark::sendPosition(SyntheticAircraft& ac, std::chrono::steady_clock::time_point now)
+	{
+		const double hours = std::chrono::duration_cast<std::chrono::milliseconds>(now - ac.lastUpdate).count() / 3600000.0;
+		const double distanceNm = ac.groundSpeed * hours;
+		const double headingRad = ac.heading * Pi / 180.0;
+		ac.latitude += distanceNm * std::cos(headingRad) / 60.0;
+		ac.longitude += distanceNm * std::sin(headingRad) / 60.0 / (std::max)(0.01, std::cos(ac.latitude * Pi / 180.0));
+		ac.lastUpdate = now;
+		ac.nextUpdate += PositionInterval;
+
+		json pos = {
+			{ "Type", "PositionUpdate" },
+			{ "Data", {
+				{ "Callsign", ac.callsign },
+				{ "Latitude", ac.latitude },
+				{ "Longitude", ac.longitude },
+				{ "Altitude", ac.altitude },
+				{ "Heading", ac.heading },
+				{ "Pitch", ac.onGround ? 0.0 : 2.0 },
+				{ "Bank", 0.0 },
+				{ "GroundSpeed", ac.groundSpeed },
+				{ "TransponderCode", 2000 },
+				{ "TransponderModeC", !ac.onGround },
+				{ "Origin", "" },
+				{ "Destination", "" },
+				{ "Timestamp", std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count() }
+			}}
+		};
+		m_handler(pos.dump());
+	}
+
+	void TrafficBenchmark::removeAircraft()
+	{
+		for (const auto& ac : m_aircraft)
+		{
+			json remove = {
+				{ "Type", "RemovePlane" },
+				{ "Data", {
+					{ "Callsign", ac.callsign }
+				}}
+			};
+			m_handler(remove.dump());
+		}
+		m_aircraft.clear();
+	}
+
+	void TrafficBenchmark::writeResults()
+	{
+		json results = {
+			{ "pluginVersion", PLUGIN_VERSION_STRING },
+			{ "timestamp", std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count() },
+			{ "units", "microseconds" },
+			{ "interpolation", Config::Instance().getCubicInterpolation() ? "cubic" : "linear" },
+			{ "steps", m_results }
+		};
+
+		std::ofstream file(m_resultPath);
+		if (!file)
+		{
+			LOG_MSG(logERROR, "Could not write traffic benchmark results to %s", m_resultPath.c_str());
+			return;
+		}
+		file << results.dump(4);
+		LOG_MSG(logMSG, "Traffic benchmark results written to %s", m_resultPath.c_str());
+	}
+}
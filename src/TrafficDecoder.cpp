@@ -0,0 +1,190 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include "TrafficDecoder.h"
+#include "AircraftManager.h"
+#include "NetworkAircraftConfig.h"
+#include "LatencyTracker.h"
+#include "XPMPMultiplayer.h"
+
+namespace xpilot
+{
+	TrafficDecoder::TrafficDecoder(AircraftManager* aircraftManager, Dispatcher dispatcher) :
+		m_aircraftManager(aircraftManager),
+		m_dispatcher(std::move(dispatcher))
+	{
+	}
+
+	bool TrafficDecoder::isTraffic(const std::string& type)
+	{
+		return type == "AddPlane"
+			|| type == "ChangeModel"
+			|| type == "PositionUpdate"
+			|| type == "FastPositionUpdate"
+			|| type == "SurfaceUpdate"
+			|| type == "RemovePlane"
+			|| type == "RemoveAllPlanes";
+	}
+
+	void TrafficDecoder::decode(const std::string& type, const json& j, long long receivedAt)
+	{
+		AircraftManager* aircraftManager = m_aircraftManager;
+
+		if (type == "AddPlane")
+		{
+			const json& data = j.at("Data");
+			std::string callsign(data.at("Callsign"));
+			std::string airline(data.at("Airline"));
+			std::string typeCode(data.at("TypeCode"));
+
+			if (!callsign.empty() && !typeCode.empty())
+			{
+				m_dispatcher([=]()
+				{
+					aircraftManager->addNewPlane(callsign, typeCode, airline);
+				});
+			}
+		}
+
+		else if (type == "ChangeModel")
+		{
+			const json& data = j.at("Data");
+			std::string callsign(data.at("Callsign"));
+			std::string airline(data.at("Airline"));
+			std::string typeCode(data.at("TypeCode"));
+
+			if (!callsign.empty() && !typeCode.empty())
+			{
+				m_dispatcher([=]()
+				{
+					aircraftManager->changeModel(callsign, typeCode, airline);
+				});
+			}
+		}
+
+		else if (type == "PositionUpdate")
+		{
+			const json& data = j.at("Data");
+			std::string callsign(data.at("Callsign"));
+
+			XPMPPlanePosition_t pos;
+			pos.lat = static_cast<double>(data.at("Latitude"));
+			pos.lon = static_cast<double>(data.at("Longitude"));
+			pos.elevation = static_cast<double>(data.at("Altitude"));
+			pos.heading = static_cast<float>(data.at("Heading"));
+			pos.pitch = static_cast<float>(data.at("Pitch"));
+			pos.roll = static_cast<float>(data.at("Bank"));
+			float gs = static_cast<float>(data.at("GroundSpeed"));
+
+			XPMPPlaneRadar_t radar;
+			radar.code = static_cast<int>(data.at("TransponderCode"));
+			radar.mode = static_cast<bool>(data.at("TransponderModeC")) ? xpmpTransponderMode_ModeC : xpmpTransponderMode_Standby;
+
+			std::string origin(data.at("Origin"));
+			std::string destination(data.at("Destination"));
+
+			// when the client sampled this position, in milliseconds since the Unix epoch;
+			// older clients don't send it
+			long long sourceTimestamp = 0;
+			if (data.find("Timestamp") != data.end())
+			{
+				sourceTimestamp = static_cast<long long>(data.at("Timestamp")) * 1000;
+			}
+
+			if (!callsign.empty())
+			{
+				const long long enqueuedAt = SteadyMicros();
+				LatencyTracker::Instance().record(LatencyHop::Decode, enqueuedAt - receivedAt);
+
+				m_dispatcher([=]()
+				{
+					const long long dequeuedAt = SteadyMicros();
+					LatencyTracker::Instance().record(LatencyHop::Queue, dequeuedAt - enqueuedAt);
+					aircraftManager->setPlanePosition(callsign, pos, radar, gs, origin, destination, sourceTimestamp, receivedAt, dequeuedAt);
+				});
+			}
+		}
+
+		else if (type == "FastPositionUpdate")
+		{
+			const json& data = j.at("Data");
+			std::string callsign(data.at("Callsign"));
+
+			VelocityState state{};
+			state.sample.latitude = static_cast<double>(data.at("Latitude"));
+			state.sample.longitude = static_cast<double>(data.at("Longitude"));
+			state.sample.altitude = static_cast<double>(data.at("Altitude"));
+			state.sample.heading = static_cast<double>(data.at("Heading"));
+			state.sample.pitch = static_cast<double>(data.at("Pitch"));
+			state.sample.bank = static_cast<double>(data.at("Bank"));
+			state.velocityNorth = static_cast<double>(data.at("VelocityNorth"));
+			state.velocityEast = static_cast<double>(data.at("VelocityEast"));
+			state.velocityUp = static_cast<double>(data.at("VelocityUp"));
+			state.pitchRate = static_cast<double>(data.at("PitchRate"));
+			state.bankRate = static_cast<double>(data.at("BankRate"));
+			state.headingRate = static_cast<double>(data.at("HeadingRate"));
+
+			long long sourceTimestamp = 0;
+			if (data.find("Timestamp") != data.end())
+			{
+				sourceTimestamp = static_cast<long long>(data.at("Timestamp")) * 1000;
+			}
+
+			if (!callsign.empty())
+			{
+				const long long enqueuedAt = SteadyMicros();
+				LatencyTracker::Instance().record(LatencyHop::Decode, enqueuedAt - receivedAt);
+
+				m_dispatcher([=]()
+				{
+					LatencyTracker::Instance().record(LatencyHop::Queue, SteadyMicros() - enqueuedAt);
+					aircraftManager->setPlaneFastPosition(callsign, state, sourceTimestamp, receivedAt);
+				});
+			}
+		}
+
+		else if (type == "SurfaceUpdate")
+		{
+			auto acconfig = j.get<NetworkAircraftConfig>();
+			m_dispatcher([=]()
+			{
+				aircraftManager->updateAircraftConfig(acconfig.data.callsign, acconfig);
+			});
+		}
+
+		else if (type == "RemovePlane")
+		{
+			std::string callsign(j.at("Data").at("Callsign"));
+			if (!callsign.empty())
+			{
+				m_dispatcher([=]()
+				{
+					aircraftManager->removePlane(callsign);
+				});
+			}
+		}
+
+		else if (type == "RemoveAllPlanes")
+		{
+			m_dispatcher([=]()
+			{
+				aircraftManager->removeAllPlanes();
+			});
+		}
+	}
+}
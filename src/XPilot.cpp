@@ -27,9 +27,20 @@
 #include "FrameRateMonitor.h"
 #include "NearbyATCWindow.h"
 #include "SettingsWindow.h"
+#include "DiagnosticsWindow.h"
+#include "Profiler.h"
+#include "PerformanceMonitor.h"
+#include "LatencyTracker.h"
+#include "Tracer.h"
 #include "NotificationPanel.h"
 #include "TextMessageConsole.h"
-#include "sha512.hh"
+#include "ZmqReactor.h"
+#include "OwnshipTelemetry.h"
+#include "SessionCapture.h"
+#include "TrafficBenchmark.h"
+#include "TrafficDecoder.h"
+#include "CslLoader.h"
+#include "PluginHash.h"
 #include "json.hpp"
 
 using json = nlohmann::json;
@@ -48,7 +59,9 @@ namespace xpilot
 		m_aircraftCount("xpilot/num_aircraft", ReadOnly),
 		m_pluginVersion("xpilot/version", ReadOnly)
 	{
+		const auto enableBegin = std::chrono::steady_clock::now();
 		thisThreadIsXP();
+		Tracer::Instance().setThreadName("X-Plane");
 
 		m_bulkDataQuick = XPLMRegisterDataAccessor("xpilot/bulk/quick",
 			xplmType_Data,
@@ -82,6 +95,72 @@ namespace xpilot
 			(void*)DR_BULK_EXPENSIVE
 		);
 
+		m_frameRateMonitor = std::make_unique<FrameRateMonitor>(this);
+		m_aircraftManager = std::make_unique<AircraftManager>();
+		m_trafficDecoder = std::make_unique<TrafficDecoder>(m_aircraftManager.get(), [this](const std::function<void()>& cb) { queueCallback(cb); });
+		m_sessionRecorder = std::make_unique<SessionRecorder>();
+		m_sessionPlayer = std::make_unique<SessionPlayer>([this](const std::string& data) { processReplayedMessage(data); });
+		m_trafficBenchmark = std::make_unique<TrafficBenchmark>([this](const std::string& data) { processMessage(data); });
+		m_cslLoader = std::make_unique<CslLoader>();
+		m_zmqReactor = std::make_unique<ZmqReactor>([this](const std::string& data)
+		{
+			m_sessionRecorder->record(data);
+			processMessage(data);
+		});
+		m_ownshipTelemetry = std::make_unique<OwnshipTelemetry>(m_zmqReactor.get());
+		m_performanceMonitor = std::make_unique<PerformanceMonitor>(m_zmqReactor.get());
+		m_zmqReactor->setOutboundSource([this](std::string& frame) { return m_ownshipTelemetry->popFrame(frame); });
+		m_pluginHash = std::make_unique<PluginHash>();
+		m_pluginVersion = PLUGIN_VERSION;
+
+		m_startup.addCompleted("Plugin Enable", enableBegin, std::chrono::steady_clock::now());
+		m_startup.add("Windows", {}, [this]()
+		{
+			createWindows();
+			return true;
+		});
+		m_startup.add("Plugin Hash", {}, [this]()
+		{
+			if (!m_pluginHash->hasStarted())
+			{
+				m_pluginHash->start(GetTruePluginPath());
+			}
+			return m_pluginHash->isReady();
+		});
+		m_startup.add("XPMP2", { "Windows" }, [this]()
+		{
+			if (!initializeXPMP())
+			{
+				m_cslLoader->start({}, "", "");
+			}
+			return true;
+		});
+		m_startup.add("CSL Packages", { "XPMP2" }, [this]()
+		{
+			// CSL packages are registered a slice per frame; traffic is only accepted once
+			// they are all in, so the first aircraft already match the right models
+			constexpr auto CslCommitBudget = std::chrono::milliseconds(10);
+			if (!m_cslLoader->commit(CslCommitBudget))
+			{
+				return false;
+			}
+			if (m_cslLoader->packageCount() > 0)
+			{
+				addNotification(string_format("Loaded %u CSL models.", (unsigned)m_cslLoader->modelsLoaded()));
+			}
+			return true;
+		});
+		m_startup.add("Network", { "CSL Packages" }, [this]()
+		{
+			startZmqServer();
+			return true;
+		});
+
+		XPLMRegisterFlightLoopCallback(deferredStartup, -1.0f, this);
+	}
+
+	void XPilot::createWindows()
+	{
 		int left, top, right, bottom, screenTop, screenRight;
 		XPLMGetScreenBoundsGlobal(nullptr, &screenTop, &screenRight, nullptr);
 		right = screenRight - 35; /*padding left*/
@@ -92,16 +171,17 @@ namespace xpilot
 		m_textMessageConsole = std::make_unique<TextMessageConsole>(this);
 		m_nearbyAtcWindow = std::make_unique<NearbyATCWindow>(this);
 		m_settingsWindow = std::make_unique<SettingsWindow>();
-		m_frameRateMonitor = std::make_unique<FrameRateMonitor>(this);
-		m_aircraftManager = std::make_unique<AircraftManager>();
-		pluginHash = sw::sha512::file(GetTruePluginPath().c_str());
-		m_pluginVersion = PLUGIN_VERSION;
-
-		XPLMRegisterFlightLoopCallback(deferredStartup, -1.0f, this);
+		m_diagnosticsWindow = std::make_unique<DiagnosticsWindow>();
 	}
 
 	XPilot::~XPilot()
 	{
+		// nothing may ask for the hash any more before it goes; its thread still sends on the socket
+		m_zmqReactor->stop();
+		m_sessionPlayer->stop();
+		m_pluginHash.reset();
+		m_cslLoader->stop();
+		m_sessionRecorder->stop();
 		XPLMUnregisterDataAccessor(m_bulkDataQuick);
 		XPLMUnregisterDataAccessor(m_bulkDataExpensive);
 		XPLMUnregisterFlightLoopCallback(deferredStartup, this);
@@ -113,102 +193,96 @@ namespace xpilot
 		auto* instance = static_cast<XPilot*>(ref);
 		if (instance)
 		{
-			instance->startZmqServer();
+			constexpr auto StartupBudget = std::chrono::milliseconds(20);
+			const bool started = instance->m_startup.run(StartupBudget);
+			AsyncLog::Instance().flushAll();
+			if (!started)
+			{
+				return -1.0f;
+			}
 		}
 		return 0;
 	}
 
 	void XPilot::startZmqServer()
 	{
-		initializeXPMP();
+		XPLMRegisterFlightLoopCallback(onFlightLoop, -1.0f, this);
 
-		if (m_zmqThread)
+		if (m_zmqReactor->start("tcp://*:" + Config::Instance().getTcpPort()))
 		{
-			m_keepAlive = false;
-			m_zmqThread->join();
-			m_zmqThread.reset();
+			LOG_CAT(Network, logMSG, "xPilot is now listening on port %s.", Config::Instance().getTcpPort().c_str());
 		}
+	}
 
-		try
-		{
-			m_zmqContext = std::make_unique<zmq::context_t>(1);
-			m_zmqSocket = std::make_unique<zmq::socket_t>(*m_zmqContext.get(), ZMQ_ROUTER);
-			m_zmqSocket->setsockopt(ZMQ_IDENTITY, "PLUGIN", 6);
-			m_zmqSocket->setsockopt(ZMQ_LINGER, 0);
-			m_zmqSocket->bind("tcp://*:" + Config::Instance().getTcpPort());
-		}
-		catch (zmq::error_t& e)
-		{
-			LOG_MSG(logERROR, "Error binding port: %s", e.what());
-		}
-		catch (const std::exception& e)
-		{
-			LOG_MSG(logERROR, "Error binding port: %s", e.what());
-		}
-		catch (...)
-		{
-		}
+	void XPilot::stopZmqServer()
+	{
+		m_zmqReactor->stop();
+	}
 
-		XPLMRegisterFlightLoopCallback(onFlightLoop, -1.0f, this);
+	void XPilot::sendSocketMsg(const std::string& msg)
+	{
+		m_zmqReactor->send(msg);
+	}
 
-		m_keepAlive = true;
-		m_zmqThread = std::make_unique<std::thread>(&XPilot::zmqWorker, this);
-		LOG_MSG(logMSG, "xPilot is now listening on port %s.", Config::Instance().getTcpPort());
+	static std::string sessionCapturePath()
+	{
+		return GetPluginPath() + "Resources/LastSession.xpcap";
 	}
 
-	void XPilot::stopZmqServer()
+	void XPilot::toggleSessionRecording()
 	{
-		try
-		{
-			if (m_zmqSocket)
-			{
-				m_zmqSocket->close();
-				m_zmqContext->close();
-			}
-		}
-		catch (zmq::error_t& e)
+		if (m_sessionRecorder->isRecording())
 		{
-			LOG_MSG(logERROR, "Error closing socket: %s", e.what());
+			m_sessionRecorder->stop();
+			addNotification("Session recording stopped.");
 		}
-		catch (std::exception& e)
+		else if (m_sessionRecorder->start(sessionCapturePath()))
 		{
-			LOG_MSG(logERROR, "Socket exception: %s", e.what());
+			addNotification("Session recording started.");
 		}
-		catch (...)
+	}
+
+	bool XPilot::isSessionRecording()const
+	{
+		return m_sessionRecorder->isRecording();
+	}
+
+	void XPilot::replaySession(double speed)
+	{
+		// replayed traffic would mix with the live traffic under the same callsigns
+		if (isNetworkConnected())
 		{
+			addNotification("A session can only be replayed while disconnected from the network.", 192, 57, 43);
+			return;
 		}
 
-		m_keepAlive = false;
-
-		if (m_zmqThread)
+		if (m_sessionRecorder->isRecording())
 		{
-			m_zmqThread->join();
-			m_zmqThread.reset();
+			m_sessionRecorder->stop();
 		}
+		m_sessionPlayer->start(sessionCapturePath(), speed);
 	}
 
-	void XPilot::sendSocketMsg(const std::string& msg)
+	void XPilot::toggleTrafficBenchmark()
 	{
-		try
+		if (m_trafficBenchmark->isRunning())
 		{
-			if (isSocketConnected() && !msg.empty())
-			{
-				std::string identity = "CLIENT";
-				zmq::message_t msg1(identity.size());
-				std::memcpy(msg1.data(), identity.data(), identity.size());
-				m_zmqSocket->send(msg1, zmq::send_flags::sndmore);
-
-				zmq::message_t message(msg.size());
-				std::memcpy(message.data(), msg.data(), msg.size());
-				m_zmqSocket->send(message, ZMQ_NOBLOCK);
-			}
+			m_trafficBenchmark->stop();
+			addNotification("Traffic benchmark stopped.");
+			return;
 		}
-		catch (zmq::error_t& e)
+
+		if (isNetworkConnected())
 		{
-			LOG_MSG(logERROR, "Error sending socket message: %s", e.what());
+			addNotification("The traffic benchmark can only be run while disconnected from the network.", 192, 57, 43);
+			return;
 		}
-		catch (...)
+
+		DataRefAccess<double> latitude("sim/flightmodel/position/latitude", ReadOnly);
+		DataRefAccess<double> longitude("sim/flightmodel/position/longitude", ReadOnly);
+		if (m_trafficBenchmark->start(latitude, longitude, GetPluginPath() + "Resources/TrafficBenchmark.json"))
 		{
+			addNotification("Traffic benchmark started. Results will be written to Resources/TrafficBenchmark.json.");
 		}
 	}
 
@@ -217,226 +291,231 @@ namespace xpilot
 		auto* instance = static_cast<XPilot*>(ref);
 		if (instance)
 		{
-			instance->invokeQueuedCallbacks();
+			// everything profiled since our last call (XPMP2, window drawing) belongs to the previous frame
+			Profiler& profiler = Profiler::Instance();
+			if (profiler.isEnabled())
+			{
+				profiler.endFrame();
+				ProfilerFrame frame;
+				if (instance->m_trafficBenchmark->isRunning() && profiler.lastFrame(frame))
+				{
+					instance->m_trafficBenchmark->onFrame(frame);
+				}
+			}
+			profiler.setEnabled(instance->m_diagnosticsWindow->GetVisible() || instance->m_trafficBenchmark->isRunning());
+
+			// timed by hand rather than with ProfileScope, the perf datarefs need these every frame
+			const auto drainStart = std::chrono::steady_clock::now();
+			const size_t queueDepth = instance->invokeQueuedCallbacks();
+			const auto drainEnd = std::chrono::steady_clock::now();
 			instance->m_aiControlled = XPMPHasControlOfAIAircraft();
 			instance->m_aircraftCount = XPMPCountPlanes();
+			const auto interpolationStart = std::chrono::steady_clock::now();
 			instance->m_aircraftManager->interpolateAirplanes();
-			UpdateMenuItems();
+			const auto interpolationEnd = std::chrono::steady_clock::now();
+
+			const long long drainMicros = std::chrono::duration_cast<std::chrono::microseconds>(drainEnd - drainStart).count();
+			const long long interpolationMicros = std::chrono::duration_cast<std::chrono::microseconds>(interpolationEnd - interpolationStart).count();
+			if (profiler.isEnabled())
+			{
+				profiler.add(ProfilerStage::QueuedCallbacks, drainMicros);
+				profiler.add(ProfilerStage::Interpolation, interpolationMicros);
+			}
+			if (Tracer::Instance().isEnabled())
+			{
+				Tracer::Instance().record(ProfilerStageName(ProfilerStage::QueuedCallbacks), drainStart, drainEnd);
+				Tracer::Instance().record(ProfilerStageName(ProfilerStage::Interpolation), interpolationStart, interpolationEnd);
+			}
+			LatencyTracker::Instance().setAdaptive(Config::Instance().getAdaptiveJitterBuffer());
+			LatencyTracker::Instance().update();
+			instance->m_performanceMonitor->onFrame(queueDepth, drainMicros, interpolationMicros);
+
+			{
+				ProfileScope profile(ProfilerStage::MenuUpdate);
+				UpdateMenuItems();
+			}
+
+			constexpr auto LogFlushBudget = std::chrono::microseconds(500);
+			AsyncLog::Instance().flush(LogFlushBudget);
 		}
 		return -1.0;
 	}
 
-	void XPilot::zmqWorker()
+	void XPilot::processMessage(const std::string& data)
 	{
-		while (isSocketReady())
+		const long long receivedAt = SteadyMicros();
+
+		if (!data.empty())
 		{
-			try
+			if (json::accept(data.c_str()))
 			{
-				zmq::message_t msg;
-				m_zmqSocket->recv(msg, zmq::recv_flags::none);
-				std::string data(static_cast<char*>(msg.data()), msg.size());
+				json j = json::parse(data.c_str());
 
-				if (!data.empty())
+				if (j.find("Type") != j.end())
 				{
-					if (json::accept(data.c_str()))
-					{
-						json j = json::parse(data.c_str());
+					std::string type(j["Type"]);
 
-						if (j.find("Type") != j.end())
+					if (!type.empty())
+					{
+						if (TrafficDecoder::isTraffic(type))
 						{
-							std::string type(j["Type"]);
+							m_trafficDecoder->decode(type, j, receivedAt);
+						}
 
-							if (!type.empty())
+						else if (type == "NetworkConnected")
+						{
+							m_networkCallsign = j["Data"]["OurCallsign"];
+							queueCallback([=]()
 							{
-								if (type == "AddPlane")
-								{
-									std::string callsign(j["Data"]["Callsign"]);
-									std::string airline(j["Data"]["Airline"]);
-									std::string typeCode(j["Data"]["TypeCode"]);
-
-									if (!callsign.empty() && !typeCode.empty())
-									{
-										queueCallback([=]()
-										{
-											m_aircraftManager->addNewPlane(callsign, typeCode, airline);
-										});
-									}
-								}
-
-								else if (type == "ChangeModel")
-								{
-									std::string callsign(j["Data"]["Callsign"]);
-									std::string airline(j["Data"]["Airline"]);
-									std::string typeCode(j["Data"]["TypeCode"]);
+								onNetworkConnected();
+							});
+						}
 
-									if (!callsign.empty() && !typeCode.empty())
-									{
-										queueCallback([=]()
-										{
-											m_aircraftManager->changeModel(callsign, typeCode, airline);
-										});
-									}
-								}
+						else if (type == "NetworkDisconnected")
+						{
+							m_networkCallsign = "";
+							queueCallback([=]()
+							{
+								onNetworkDisconnected();
+							});
+						}
 
-								else if (type == "PositionUpdate")
-								{
-									std::string callsign(j["Data"]["Callsign"]);
+						else if (type == "WhosOnline")
+						{
+							queueCallback([=]()
+							{
+								m_nearbyAtcWindow->UpdateList(j);
+							});
+						}
 
-									XPMPPlanePosition_t pos;
-									pos.lat = static_cast<double>(j["Data"]["Latitude"]);
-									pos.lon = static_cast<double>(j["Data"]["Longitude"]);
-									pos.elevation = static_cast<double>(j["Data"]["Altitude"]);
-									pos.heading = static_cast<float>(j["Data"]["Heading"]);
-									pos.pitch = static_cast<float>(j["Data"]["Pitch"]);
-									pos.roll = static_cast<float>(j["Data"]["Bank"]);
-									float gs = static_cast<float>(j["Data"]["GroundSpeed"]);
+						else if (type == "PluginVersion")
+						{
+							json reply;
+							reply["Type"] = "PluginVersion";
+							reply["Timestamp"] = UtcTimestamp();
+							reply["Data"]["Version"] = PLUGIN_VERSION;
+							sendSocketMsg(reply.dump());
+						}
 
-									XPMPPlaneRadar_t radar;
-									radar.code = static_cast<int>(j["Data"]["TransponderCode"]);
-									radar.mode = static_cast<bool>(j["Data"]["TransponderModeC"]) ? xpmpTransponderMode_ModeC : xpmpTransponderMode_Standby;
+						else if (type == "PluginHash")
+						{
+							// answered from the hashing thread if the hash isn't ready yet
+							m_pluginHash->get([this](const std::string& hash)
+							{
+								json j;
+								j["Type"] = "PluginHash";
+								j["Data"]["Hash"] = hash;
+								j["Timestamp"] = UtcTimestamp();
+								sendSocketMsg(j.dump());
+							});
+						}
 
-									std::string origin(j["Data"]["Origin"]);
-									std::string destination(j["Data"]["Destination"]);
+						else if (type == "RadioMessage")
+						{
+							std::string msg(j["Data"]["Message"]);
 
-									if (!callsign.empty())
-									{
-										queueCallback([=]()
-										{
-											m_aircraftManager->setPlanePosition(callsign, pos, radar, gs, origin, destination);
-										});
-									}
-								}
+							int red = static_cast<int>(j["Data"]["R"]);
+							int green = static_cast<int>(j["Data"]["G"]);
+							int blue = static_cast<int>(j["Data"]["B"]);
+							bool direct = static_cast<bool>(j["Data"]["Direct"]);
 
-								else if (type == "SurfaceUpdate")
-								{
-									auto acconfig = j.get<NetworkAircraftConfig>();
-									queueCallback([=]()
-									{
-										m_aircraftManager->updateAircraftConfig(acconfig.data.callsign, acconfig);
-									});
-								}
+							addNotification(msg, red, green, blue);
+						}
 
-								else if (type == "RemovePlane")
-								{
-									std::string callsign(j["Data"]["Callsign"]);
-									if (!callsign.empty())
-									{
-										queueCallback([=]()
-										{
-											m_aircraftManager->removePlane(callsign);
-										});
-									}
-								}
+						else if (type == "PrivateMessageReceived")
+						{
+							std::string msg(j["Data"]["Message"]);
+							std::string from(j["Data"]["From"]);
 
-								else if (type == "RemoveAllPlanes")
-								{
-									queueCallback([=]()
-									{
-										m_aircraftManager->removeAllPlanes();
-									});
-								}
+							addConsoleMessageTab(from, msg, ConsoleTabType::Incoming);
+							addNotificationPanelMessage(string_format("%s [pvt]:  %s", from, msg.c_str()), 230, 94, 230);
+						}
 
-								else if (type == "NetworkConnected")
-								{
-									m_networkCallsign = j["Data"]["OurCallsign"];
-									queueCallback([=]()
-									{
-										onNetworkConnected();
-									});
-								}
+						else if (type == "PrivateMessageSent")
+						{
+							std::string msg(j["Data"]["Message"]);
+							std::string from(j["Data"]["To"]);
 
-								else if (type == "NetworkDisconnected")
-								{
-									m_networkCallsign = "";
-									queueCallback([=]()
-									{
-										onNetworkDisconnected();
-									});
-								}
+							addConsoleMessageTab(from, msg, ConsoleTabType::Outgoing);
+							addNotificationPanelMessage(string_format("%s [pvt: %s]:  %s", m_networkCallsign.value().c_str(), from.c_str(), msg.c_str()), 50, 205, 50);
+						}
 
-								else if (type == "WhosOnline")
+						else if (type == "NegotiateCompression")
+						{
+							bool lz4 = false;
+							if (j["Data"].find("Algorithms") != j["Data"].end())
+							{
+								for (auto& algorithm : j["Data"]["Algorithms"])
 								{
-									queueCallback([=]()
+									if (algorithm.is_string() && str_tolower(algorithm.get<std::string>()) == "lz4")
 									{
-										m_nearbyAtcWindow->UpdateList(j);
-									});
-								}
-
-								else if (type == "PluginVersion")
-								{
-									json reply;
-									reply["Type"] = "PluginVersion";
-									reply["Timestamp"] = UtcTimestamp();
-									reply["Data"]["Version"] = PLUGIN_VERSION;
-									sendSocketMsg(reply.dump());
-								}
-
-								else if (type == "PluginHash")
-								{
-									json j;
-									j["Type"] = "PluginHash";
-									j["Data"]["Hash"] = pluginHash;
-									j["Timestamp"] = UtcTimestamp();
-									sendSocketMsg(j.dump());
-								}
-
-								else if (type == "RadioMessage")
-								{
-									std::string msg(j["Data"]["Message"]);
-
-									int red = static_cast<int>(j["Data"]["R"]);
-									int green = static_cast<int>(j["Data"]["G"]);
-									int blue = static_cast<int>(j["Data"]["B"]);
-									bool direct = static_cast<bool>(j["Data"]["Direct"]);
-
-									addNotification(msg, red, green, blue);
+										lz4 = true;
+									}
 								}
+							}
 
-								else if (type == "PrivateMessageReceived")
-								{
-									std::string msg(j["Data"]["Message"]);
-									std::string from(j["Data"]["From"]);
-
-									addConsoleMessageTab(from, msg, ConsoleTabType::Incoming);
-									addNotificationPanelMessage(string_format("%s [pvt]:  %s", from, msg.c_str()), 230, 94, 230);
-								}
+							size_t threshold = DefaultCompressionThreshold;
+							if (j["Data"].find("Threshold") != j["Data"].end())
+							{
+								threshold = (std::max)(static_cast<size_t>(j["Data"]["Threshold"]), MinCompressionThreshold);
+							}
 
-								else if (type == "PrivateMessageSent")
-								{
-									std::string msg(j["Data"]["Message"]);
-									std::string from(j["Data"]["To"]);
+							json reply;
+							reply["Type"] = "NegotiateCompression";
+							reply["Timestamp"] = UtcTimestamp();
+							reply["Data"]["Algorithm"] = lz4 ? "lz4" : "none";
+							reply["Data"]["Threshold"] = threshold;
+							sendSocketMsg(reply.dump());
 
-									addConsoleMessageTab(from, msg, ConsoleTabType::Outgoing);
-									addNotificationPanelMessage(string_format("%s [pvt: %s]:  %s", m_networkCallsign.value().c_str(), from.c_str(), msg.c_str()), 50, 205, 50);
-								}
+							// the reply is below the minimum threshold, so it always goes out uncompressed
+							m_zmqReactor->setCompression(lz4, threshold);
+							LOG_CAT(Network, logINFO, "Socket compression: %s (threshold %llu bytes)", lz4 ? "lz4" : "none", (unsigned long long)threshold);
+						}
 
-								else if (type == "ValidateCslPaths")
-								{
-									json j;
-									j["Type"] = "ValidateCslPaths";
-									j["Data"]["Result"] = Config::Instance().hasValidPaths() && XPMPGetNumberOfInstalledModels() > 0;
-									j["Timestamp"] = UtcTimestamp();
-									sendSocketMsg(j.dump());
-								}
+						else if (type == "RequestTelemetry")
+						{
+							float rate = 0.0f;
+							if (j["Data"].find("Rate") != j["Data"].end())
+							{
+								rate = static_cast<float>(j["Data"]["Rate"]);
 							}
+							queueCallback([=]()
+							{
+								m_ownshipTelemetry->setRate(rate);
+							});
+						}
+
+						else if (type == "ValidateCslPaths")
+						{
+							json j;
+							j["Type"] = "ValidateCslPaths";
+							j["Data"]["Result"] = Config::Instance().hasValidPaths() && XPMPGetNumberOfInstalledModels() > 0;
+							j["Timestamp"] = UtcTimestamp();
+							sendSocketMsg(j.dump());
 						}
 					}
 				}
 			}
-			catch (zmq::error_t& e)
-			{
-				if (e.num() != ETERM)
-				{
-					LOG_MSG(logERROR, "Socket recv exception: %s", e.what());
-				}
-			}
-			catch (std::exception& e)
-			{
-				LOG_MSG(logERROR, "Socket recv exception: %s", e.what());
-			}
-			catch (...)
-			{
-			}
+		}
+	}
+
+	void XPilot::processReplayedMessage(const std::string& data)
+	{
+		const long long receivedAt = SteadyMicros();
+
+		// a capture holds everything the client sent; only the traffic is replayed, the rest
+		// (connection state, compression, telemetry, replies, messages) belongs to the live session
+		if (data.empty() || !json::accept(data.c_str()))
+			return;
+
+		json j = json::parse(data.c_str());
+		if (j.find("Type") == j.end())
+			return;
+
+		std::string type(j["Type"]);
+		if (TrafficDecoder::isTraffic(type))
+		{
+			m_trafficDecoder->decode(type, j, receivedAt);
 		}
 	}
 
@@ -507,16 +586,17 @@ namespace xpilot
 
 		if (*err)
 		{
-			LOG_MSG(logERROR, "Error initializing multiplayer: %s", err);
+			LOG_CAT(Csl, logERROR, "Error initializing multiplayer: %s", err);
 			XPMPMultiplayerCleanup();
 			return false;
 		}
 
+		std::vector<std::string> packages;
 		if (!Config::Instance().hasValidPaths())
 		{
 			std::string err = "No valid CSL paths are configured or the paths are disabled. Verify the CSL configuration in X-Plane (Plugins > xPilot > Settings > CSL Packages).";
 			addNotification(err.c_str(), 192, 57, 43);
-			LOG_MSG(logERROR, err.c_str());
+			LOG_CAT(Csl, logERROR, err.c_str());
 		}
 		else
 		{
@@ -524,21 +604,12 @@ namespace xpilot
 			{
 				if (!p.path.empty() && p.enabled && CountFilesInPath(p.path) > 0)
 				{
-					try
-					{
-						err = XPMPLoadCSLPackage(p.path.c_str());
-						if (*err)
-						{
-							LOG_MSG(logERROR, "Error loading CSL package %s: %s", p.path.c_str(), err);
-						}
-					}
-					catch (std::exception& e)
-					{
-						LOG_MSG(logERROR, "Error loading CSL package %s: %s", p.path.c_str(), err);
-					}
+					packages.push_back(p.path);
 				}
 			}
+			addNotification("Loading CSL packages...");
 		}
+		m_cslLoader->start(packages, pathResources + "/CslIndex.bin", pathResources + "/Doc8643.txt");
 
 		XPMPEnableAircraftLabels(Config::Instance().getShowHideLabels());
 		XPMPSetAircraftLabelDist(Config::Instance().getMaxLabelDistance(), Config::Instance().getLabelCutoffVis());
@@ -586,48 +657,81 @@ namespace xpilot
 
 	void XPilot::queueCallback(const std::function<void()> &cb)
 	{
+		TraceScope trace("Queue Callback");
 		std::lock_guard<std::mutex> lck(m_mutex);
 		m_queuedCallbacks.push_back(cb);
 	}
 
-	void XPilot::invokeQueuedCallbacks()
+	size_t XPilot::invokeQueuedCallbacks()
 	{
 		std::deque<std::function<void()>> temp;
 		{
 			std::lock_guard<std::mutex> lck(m_mutex);
 			std::swap(temp, m_queuedCallbacks);
 		}
+		const size_t count = temp.size();
 		while (!temp.empty())
 		{
 			auto cb = temp.front();
 			temp.pop_front();
 			cb();
 		}
+		return count;
 	}
 
 	void XPilot::togglePreferencesWindow()
 	{
+		if (!m_settingsWindow) return; // the windows are created on the first frame
 		m_settingsWindow->SetVisible(!m_settingsWindow->GetVisible());
 	}
 
 	void XPilot::toggleNearbyAtcWindow()
 	{
+		if (!m_nearbyAtcWindow) return;
 		m_nearbyAtcWindow->SetVisible(!m_nearbyAtcWindow->GetVisible());
 	}
 
 	void XPilot::toggleTextMessageConsole()
 	{
+		if (!m_textMessageConsole) return;
 		m_textMessageConsole->SetVisible(!m_textMessageConsole->GetVisible());
 	}
 
+	void XPilot::toggleDiagnosticsWindow()
+	{
+		if (!m_diagnosticsWindow) return;
+		m_diagnosticsWindow->SetVisible(!m_diagnosticsWindow->GetVisible());
+	}
+
+	void XPilot::toggleTracing()
+	{
+		Tracer::Instance().setEnabled(!Tracer::Instance().isEnabled());
+		addNotification(Tracer::Instance().isEnabled() ? "Tracing started." : "Tracing stopped.");
+	}
+
+	bool XPilot::isTracing()const
+	{
+		return Tracer::Instance().isEnabled();
+	}
+
+	void XPilot::saveTrace()
+	{
+		const std::string path = GetPluginPath() + "Resources/xpilot-trace.json";
+		if (Tracer::Instance().dump(path))
+		{
+			addNotification("Trace saved to Resources/xpilot-trace.json. Open it in Perfetto or chrome://tracing.");
+		}
+	}
+
 	void XPilot::setNotificationPanelAlwaysVisible(bool visible)
 	{
+		if (!m_notificationPanel) return;
 		m_notificationPanel->setAlwaysVisible(visible);
 	}
 
 	bool XPilot::setNotificationPanelAlwaysVisible()const
 	{
-		return m_notificationPanel->isAlwaysVisible();
+		return m_notificationPanel && m_notificationPanel->isAlwaysVisible();
 	}
 
 	void XPilot::incrementAircraftCount()
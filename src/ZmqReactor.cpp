@@ -0,0 +1,340 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2020 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include <vector>
+#include <chrono>
+
+#include "ZmqReactor.h"
+#include "Utilities.h"
+#include "Tracer.h"
+
+namespace xpilot
+{
+	static const std::string ClientIdentity = "CLIENT";
+
+	ZmqReactor::ZmqReactor(MessageHandler handler, size_t batchSize) :
+		m_handler(handler),
+		m_batchSize(batchSize > 0 ? batchSize : 1),
+		m_wakeEndpoint("inproc://xpilot-reactor")
+	{
+	}
+
+	ZmqReactor::~ZmqReactor()
+	{
+		stop();
+	}
+
+	bool ZmqReactor::start(const std::string& endpoint)
+	{
+		stop();
+
+		try
+		{
+			m_context = std::make_unique<zmq::context_t>(1);
+
+			m_router = std::make_unique<zmq::socket_t>(*m_context.get(), ZMQ_ROUTER);
+			m_router->setsockopt(ZMQ_IDENTITY, "PLUGIN", 6);
+			m_router->setsockopt(ZMQ_LINGER, 0);
+			m_router->bind(endpoint);
+
+			m_wakeRecv = std::make_unique<zmq::socket_t>(*m_context.get(), ZMQ_PAIR);
+			m_wakeRecv->setsockopt(ZMQ_LINGER, 0);
+			m_wakeRecv->bind(m_wakeEndpoint);
+
+			m_wakeSend = std::make_unique<zmq::socket_t>(*m_context.get(), ZMQ_PAIR);
+			m_wakeSend->setsockopt(ZMQ_LINGER, 0);
+			m_wakeSend->connect(m_wakeEndpoint);
+		}
+		catch (zmq::error_t& e)
+		{
+			LOG_CAT(Network, logERROR, "Error binding port: %s", e.what());
+			stop();
+			return false;
+		}
+
+		m_stats.iterations = 0;
+		m_stats.wakeups = 0;
+		m_stats.timeouts = 0;
+		m_stats.messagesIn = 0;
+		m_stats.messagesOut = 0;
+		m_stats.bytesIn = 0;
+		m_stats.bytesOut = 0;
+		m_stats.compressedIn = 0;
+		m_stats.compressedOut = 0;
+		m_stats.uncompressedBytesOut = 0;
+		m_stats.maxBatch = 0;
+		m_stats.busyMicros = 0;
+
+		m_wakePending = false;
+		m_compressionEnabled = false;
+		m_running = true;
+		m_thread = std::make_unique<std::thread>(&ZmqReactor::run, this);
+		return true;
+	}
+
+	void ZmqReactor::stop()
+	{
+		if (m_thread)
+		{
+			signal(CmdStop);
+			m_thread->join();
+			m_thread.reset();
+
+			LOG_CAT(Network, logINFO, "ZMQ reactor stopped: %llu iterations (%llu wakeups, %llu idle), %llu msgs in (%llu bytes, %llu compressed), %llu msgs out (%llu bytes, %llu before compression, %llu compressed), max batch %llu, busy %.1f ms",
+				(unsigned long long)m_stats.iterations, (unsigned long long)m_stats.wakeups, (unsigned long long)m_stats.timeouts,
+				(unsigned long long)m_stats.messagesIn, (unsigned long long)m_stats.bytesIn, (unsigned long long)m_stats.compressedIn,
+				(unsigned long long)m_stats.messagesOut, (unsigned long long)m_stats.bytesOut,
+				(unsigned long long)m_stats.uncompressedBytesOut, (unsigned long long)m_stats.compressedOut,
+				(unsigned long long)m_stats.maxBatch, m_stats.busyMicros / 1000.0);
+		}
+
+		m_running = false;
+
+		// the I/O thread has exited at this point, so it is safe to close its sockets here
+		try
+		{
+			std::lock_guard<std::mutex> wakeLock(m_wakeMutex);
+			std::lock_guard<std::mutex> lock(m_outboxMutex);
+			if (m_wakeSend) m_wakeSend->close();
+			if (m_wakeRecv) m_wakeRecv->close();
+			if (m_router) m_router->close();
+			if (m_context) m_context->close();
+			m_wakeSend.reset();
+			m_wakeRecv.reset();
+			m_router.reset();
+			m_context.reset();
+			m_outbox.clear();
+		}
+		catch (zmq::error_t& e)
+		{
+			LOG_CAT(Network, logERROR, "Error closing socket: %s", e.what());
+		}
+	}
+
+	void ZmqReactor::send(const std::string& msg)
+	{
+		if (msg.empty() || !m_running)
+			return;
+
+		{
+			std::lock_guard<std::mutex> lock(m_outboxMutex);
+			m_outbox.push_back(msg);
+		}
+		signal(CmdWake);
+	}
+
+	void ZmqReactor::signal(ControlCommand cmd)
+	{
+		// coalesce wake-ups; the I/O thread clears the flag before it drains the outbox
+		if (cmd == CmdWake && m_wakePending.exchange(true))
+			return;
+
+		try
+		{
+			// the I/O thread never takes this one, so waking it can't wait on an outbox drain
+			std::lock_guard<std::mutex> lock(m_wakeMutex);
+			if (m_wakeSend)
+			{
+				const char c = cmd;
+				m_wakeSend->send(zmq::message_t(&c, 1), zmq::send_flags::dontwait);
+			}
+		}
+		catch (zmq::error_t& e)
+		{
+			LOG_CAT(Network, logERROR, "Error signaling socket thread: %s", e.what());
+		}
+	}
+
+	void ZmqReactor::run()
+	{
+		zmq::pollitem_t items[] = {
+			{ m_wakeRecv->handle(), 0, ZMQ_POLLIN, 0 },
+			{ m_router->handle(), 0, ZMQ_POLLIN, 0 }
+		};
+
+		bool keepRunning = true;
+		bool backlog = false;
+
+		Tracer::Instance().setThreadName("ZMQ Reactor");
+
+		while (keepRunning)
+		{
+			try
+			{
+				zmq::poll(items, 2, backlog ? 0 : PollTimeoutMs);
+
+				const auto busyStart = std::chrono::steady_clock::now();
+				m_stats.iterations++;
+
+				if (items[0].revents & ZMQ_POLLIN)
+				{
+					m_stats.wakeups++;
+					zmq::message_t cmd;
+					while (m_wakeRecv->recv(cmd, zmq::recv_flags::dontwait))
+					{
+						if (cmd.size() > 0 && *cmd.data<char>() == CmdStop)
+						{
+							keepRunning = false;
+						}
+					}
+					m_wakePending = false;
+				}
+
+				size_t received = 0;
+				if (items[1].revents & ZMQ_POLLIN)
+				{
+					received = drainInbound();
+				}
+
+				bool outboxBacklog = false;
+				size_t sent = drainOutbound(outboxBacklog);
+
+				backlog = received >= m_batchSize || outboxBacklog;
+
+				if (!items[0].revents && !items[1].revents && sent == 0)
+				{
+					m_stats.timeouts++;
+				}
+				if (received + sent > m_stats.maxBatch)
+				{
+					m_stats.maxBatch = received + sent;
+				}
+
+				m_stats.busyMicros += std::chrono::duration_cast<std::chrono::microseconds>(
+					std::chrono::steady_clock::now() - busyStart).count();
+			}
+			catch (zmq::error_t& e)
+			{
+				if (e.num() == ETERM)
+					break;
+				LOG_CAT(Network, logERROR, "Socket loop exception: %s", e.what());
+			}
+			catch (std::exception& e)
+			{
+				LOG_CAT(Network, logERROR, "Socket loop exception: %s", e.what());
+			}
+		}
+	}
+
+	size_t ZmqReactor::drainInbound()
+	{
+		size_t count = 0;
+		while (count < m_batchSize)
+		{
+			zmq::message_t frame;
+			if (!m_router->recv(frame, zmq::recv_flags::dontwait))
+				break;
+
+			// the ROUTER socket prefixes the payload with the sender's identity frame
+			while (frame.more())
+			{
+				if (!m_router->recv(frame, zmq::recv_flags::none))
+					break;
+			}
+
+			++count;
+			m_stats.messagesIn++;
+			m_stats.bytesIn += frame.size();
+
+			if (frame.size() > 0 && m_handler)
+			{
+				TraceScope trace("Decode Message");
+				try
+				{
+					if (IsCompressedFrame(frame.data(), frame.size()))
+					{
+						std::string msg;
+						if (!DecompressFrame(frame.data(), frame.size(), msg))
+						{
+							LOG_CAT(Network, logERROR, "Dropping malformed compressed frame (%llu bytes)", (unsigned long long)frame.size());
+							continue;
+						}
+						m_stats.compressedIn++;
+						m_handler(msg);
+					}
+					else
+					{
+						m_handler(std::string(frame.data<char>(), frame.size()));
+					}
+				}
+				catch (std::exception& e)
+				{
+					LOG_CAT(Network, logERROR, "Socket recv exception: %s", e.what());
+				}
+			}
+		}
+		return count;
+	}
+
+	size_t ZmqReactor::drainOutbound(bool& backlog)
+	{
+		std::vector<std::string> batch;
+		{
+			std::lock_guard<std::mutex> lock(m_outboxMutex);
+			const size_t n = (std::min)(m_batchSize, m_outbox.size());
+			batch.reserve(n);
+			for (size_t i = 0; i < n; i++)
+			{
+				batch.push_back(std::move(m_outbox.front()));
+				m_outbox.pop_front();
+			}
+			backlog = !m_outbox.empty();
+		}
+
+		if (m_outboundSource)
+		{
+			std::string frame;
+			while (batch.size() < m_batchSize && m_outboundSource(frame))
+			{
+				batch.push_back(std::move(frame));
+			}
+			if (batch.size() >= m_batchSize)
+			{
+				backlog = true;
+			}
+		}
+
+		const bool compress = m_compressionEnabled;
+		const size_t threshold = m_compressionThreshold;
+		std::string compressed;
+
+		for (const std::string& msg : batch)
+		{
+			try
+			{
+				const std::string* payload = &msg;
+				if (compress && msg.size() >= threshold && CompressFrame(msg, compressed))
+				{
+					payload = &compressed;
+					m_stats.compressedOut++;
+				}
+
+				m_router->send(zmq::message_t(ClientIdentity.data(), ClientIdentity.size()), zmq::send_flags::sndmore);
+				m_router->send(zmq::message_t(payload->data(), payload->size()), zmq::send_flags::dontwait);
+				m_stats.messagesOut++;
+				m_stats.bytesOut += payload->size();
+				m_stats.uncompressedBytesOut += msg.size();
+			}
+			catch (zmq::error_t& e)
+			{
+				LOG_CAT(Network, logERROR, "Error sending socket message: %s", e.what());
+			}
+		}
+		return batch.size();
+	}
+}